@@ -0,0 +1,262 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+/*
+  Bit stream benchmark.
+
+  Writes and reads streams of values of a fixed or random number of bits,
+  as the base mesh coding does, with BitWriter and BitReader and with the
+  per-call writeBits() and readBits() functions that they replaced. Both
+  must produce the same bytes and read back the same values.
+
+  For each stream and implementation, the speeds are given in nanoseconds
+  per value, the best of several repetitions.
+
+  Usage: bitbench
+*/
+
+#include "bitStream.h"
+
+#include "rangeCoder/databuffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// Minimal number of repetitions and duration of the measure of a stream.
+#define BENCH_MIN_REPETITIONS 3
+#define BENCH_MIN_SECONDS 0.5
+
+// Number of values of a stream.
+#define BENCH_STREAM_LENGTH 4000000
+
+// Maximal number of bits of a value for writeBits() and readBits().
+#define PER_CALL_MAX_NB_BITS 25
+
+// Values to write and their number of bits.
+struct BitStream {
+    unsigned i_minNbBits;
+    unsigned i_maxNbBits;
+    std::vector<uint32_t> values;
+    std::vector<unsigned> nbBits;
+};
+
+/**
+ * Write a given number of bits in a buffer.
+ * The per-call writer that BitWriter replaced. The offset points one byte after the partially written byte.
+ */
+static void writeBits(uint32_t data, unsigned i_nbBits, databuffer* p_buffer, unsigned& i_bitOffset) {
+    assert(i_nbBits <= PER_CALL_MAX_NB_BITS);
+
+    // The 4 bytes starting at the current partially written byte are modified.
+    reservedatabuffer(p_buffer, p_buffer->offset + sizeof(uint32_t) - 1);
+    char* p_dest = p_buffer->p_data + p_buffer->offset - 1;
+
+    uint32_t dataToAdd = data << (32 - i_nbBits - i_bitOffset);
+    dataToAdd = __builtin_bswap32(dataToAdd);
+    *(uint32_t*)p_dest |= dataToAdd;
+
+    p_buffer->offset += (i_bitOffset + i_nbBits) / 8;
+    i_bitOffset = (i_bitOffset + i_nbBits) % 8;
+    if (p_buffer->offset > p_buffer->size)
+        p_buffer->size = p_buffer->offset;
+}
+
+/**
+ * Read a given number of bits in a buffer.
+ * The per-call reader that BitReader replaced.
+ */
+static uint32_t readBits(unsigned i_nbBits, databuffer* p_buffer, unsigned& i_bitOffset) {
+    assert(i_nbBits <= PER_CALL_MAX_NB_BITS);
+
+    // Load the 4 bytes starting at the current partially read byte.
+    size_t i_start = p_buffer->offset - 1;
+    uint32_t data = 0;
+    if (i_start + sizeof(uint32_t) <= p_buffer->size)
+        data = *(uint32_t*)(p_buffer->p_data + i_start);
+    else {
+        for (unsigned i = 0; i < sizeof(uint32_t) && i_start + i < p_buffer->size; ++i)
+            ((char*)&data)[i] = p_buffer->p_data[i_start + i];
+    }
+
+    uint32_t mask = 0;
+    for (unsigned i = 0; i < 32 - i_bitOffset; ++i)
+        mask |= 1 << i;
+    mask = __builtin_bswap32(mask);
+
+    data &= mask;
+    data = __builtin_bswap32(data);
+    data >>= 32 - i_nbBits - i_bitOffset;
+
+    p_buffer->offset += (i_bitOffset + i_nbBits) / 8;
+    i_bitOffset = (i_bitOffset + i_nbBits) % 8;
+
+    return data;
+}
+
+// Clear the buffer before a stream is written, as writeBits() ors the values in it.
+static void clearBuffer(databuffer& buffer) {
+    if (buffer.size > 0)
+        memset(buffer.p_data, 0, buffer.size);
+    buffer.offset = 0;
+    buffer.size = 0;
+}
+
+/**
+ * Write a stream with writeBits() or BitWriter.
+ * \return the number of bytes written.
+ */
+static size_t writeStream(databuffer& buffer, const BitStream& stream, bool b_buffered) {
+    clearBuffer(buffer);
+
+    if (b_buffered) {
+        BitWriter bits(&buffer);
+        for (size_t i = 0; i < stream.values.size(); ++i)
+            bits.write(stream.values[i], stream.nbBits[i]);
+        bits.flush();
+    }
+    else {
+        unsigned i_bitOffset = 0;
+        buffer.offset++;
+        for (size_t i = 0; i < stream.values.size(); ++i)
+            writeBits(stream.values[i], stream.nbBits[i], &buffer, i_bitOffset);
+        if (i_bitOffset == 0)
+            buffer.offset--;
+        buffer.size = buffer.offset;
+    }
+
+    return buffer.offset;
+}
+
+/**
+ * Read a stream with readBits() or BitReader.
+ * \return the number of values different from the stream ones.
+ */
+static size_t readStream(databuffer& buffer, const BitStream& stream, bool b_buffered) {
+    size_t i_nbErrors = 0;
+
+    buffer.offset = 0;
+    if (b_buffered) {
+        BitReader bits(&buffer);
+        for (size_t i = 0; i < stream.values.size(); ++i)
+            i_nbErrors += bits.read(stream.nbBits[i]) != stream.values[i];
+        bits.finish();
+    }
+    else {
+        unsigned i_bitOffset = 0;
+        buffer.offset++;
+        for (size_t i = 0; i < stream.values.size(); ++i)
+            i_nbErrors += readBits(stream.nbBits[i], &buffer, i_bitOffset) != stream.values[i];
+    }
+
+    return i_nbErrors;
+}
+
+static double elapsedSeconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Measure the writing and reading of a stream with an implementation and print the results.
+ * \return false if the values read are not the stream ones.
+ */
+static bool benchStream(databuffer& buffer, const BitStream& stream, bool b_buffered) {
+    size_t i_size = 0, i_nbErrors = 0;
+    double f_writeSeconds = 1e30, f_readSeconds = 1e30, f_totalSeconds = 0;
+    for (unsigned i = 0; i < BENCH_MIN_REPETITIONS || f_totalSeconds < BENCH_MIN_SECONDS; ++i) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        i_size = writeStream(buffer, stream, b_buffered);
+        double f_seconds = elapsedSeconds(start);
+        f_writeSeconds = std::min(f_writeSeconds, f_seconds);
+        f_totalSeconds += f_seconds;
+
+        start = std::chrono::steady_clock::now();
+        i_nbErrors += readStream(buffer, stream, b_buffered);
+        f_seconds = elapsedSeconds(start);
+        f_readSeconds = std::min(f_readSeconds, f_seconds);
+        f_totalSeconds += f_seconds;
+    }
+
+    size_t i_nbValues = stream.values.size();
+    printf("%4u-%-4u %-9s %10lu %10lu %12.2f %12.2f\n", stream.i_minNbBits, stream.i_maxNbBits,
+           b_buffered ? "buffered" : "per-call", (unsigned long)i_nbValues, (unsigned long)i_size,
+           f_writeSeconds * 1e9 / i_nbValues, f_readSeconds * 1e9 / i_nbValues);
+
+    if (i_nbErrors != 0) {
+        printf("%lu values are read wrong.\n", (unsigned long)i_nbErrors);
+        return false;
+    }
+    return true;
+}
+
+// Build a stream of random values whose number of bits is uniform between i_minNbBits and i_maxNbBits.
+static BitStream randomStream(unsigned i_minNbBits, unsigned i_maxNbBits) {
+    BitStream stream;
+    stream.i_minNbBits = i_minNbBits;
+    stream.i_maxNbBits = i_maxNbBits;
+
+    // A xorshift generator, so that the streams are the same on every platform.
+    uint32_t i_state = 2463534242u;
+    for (unsigned i = 0; i < BENCH_STREAM_LENGTH; ++i) {
+        i_state ^= i_state << 13;
+        i_state ^= i_state >> 17;
+        i_state ^= i_state << 5;
+        unsigned i_nbBits = i_minNbBits + i_state % (i_maxNbBits - i_minNbBits + 1);
+        stream.nbBits.push_back(i_nbBits);
+        stream.values.push_back(i_nbBits == 32 ? i_state : i_state & ((1u << i_nbBits) - 1));
+    }
+
+    return stream;
+}
+
+int main() {
+    // Vertex ids and coordinates of the base mesh, and the widths in between.
+    std::vector<BitStream> streams;
+    streams.push_back(randomStream(1, 1));
+    streams.push_back(randomStream(3, 3));
+    streams.push_back(randomStream(12, 12));
+    streams.push_back(randomStream(PER_CALL_MAX_NB_BITS, PER_CALL_MAX_NB_BITS));
+    streams.push_back(randomStream(1, PER_CALL_MAX_NB_BITS));
+
+    databuffer buffer, perCallBuffer;
+    initdatabuffer(&buffer);
+    initdatabuffer(&perCallBuffer);
+
+    printf("%-9s %-9s %10s %10s %12s %12s\n", "bits", "stream", "values", "bytes", "write ns/val", "read ns/val");
+
+    bool b_ok = true;
+    for (const BitStream& stream : streams) {
+        b_ok = benchStream(perCallBuffer, stream, false) && b_ok;
+        b_ok = benchStream(buffer, stream, true) && b_ok;
+
+        // The layout of the bits did not change.
+        if (buffer.size != perCallBuffer.size || memcmp(buffer.p_data, perCallBuffer.p_data, buffer.size) != 0) {
+            printf("The two implementations wrote different bytes.\n");
+            b_ok = false;
+        }
+    }
+
+    deletedatabuffer(&buffer);
+    deletedatabuffer(&perCallBuffer);
+    return b_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
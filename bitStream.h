@@ -0,0 +1,159 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef BITSTREAM_H
+#define BITSTREAM_H
+
+#include <assert.h>
+#include <stdint.h>
+
+#include "rangeCoder/databuffer.h"
+
+/*
+  Bit stream writer and reader on a data buffer.
+
+  The values are packed most significant bit first, starting at the
+  current offset of the buffer. The last byte is padded with zeros, so a
+  stream of n bits always takes ceil(n / 8) bytes. The bits go through a
+  64 bits accumulator and the buffer is accessed 4 bytes at a time.
+*/
+
+class BitWriter {
+  public:
+    BitWriter(databuffer* p_buffer) : p_buffer(p_buffer), i_bits(0), i_nbPendingBits(0) {}
+
+    ~BitWriter() {
+        assert(i_nbPendingBits == 0);
+    }
+
+    // Write the i_nbBits (at most 32) lower bits of data.
+    inline void write(uint32_t data, unsigned i_nbBits) {
+        assert(i_nbBits <= 32 && (i_nbBits == 32 || data >> i_nbBits == 0));
+
+        i_bits = (i_bits << i_nbBits) | data;
+        i_nbPendingBits += i_nbBits;
+
+        if (i_nbPendingBits >= 32) {
+            i_nbPendingBits -= 32;
+            uint32_t word = (uint32_t)(i_bits >> i_nbPendingBits);
+
+            if (p_buffer->offset + sizeof(uint32_t) > p_buffer->capacity)
+                reservedatabuffer(p_buffer, p_buffer->offset + sizeof(uint32_t));
+            unsigned char* p_dest = (unsigned char*)p_buffer->p_data + p_buffer->offset;
+            p_dest[0] = word >> 24;
+            p_dest[1] = word >> 16;
+            p_dest[2] = word >> 8;
+            p_dest[3] = word;
+            p_buffer->offset += sizeof(uint32_t);
+            if (p_buffer->offset > p_buffer->size)
+                p_buffer->size = p_buffer->offset;
+        }
+    }
+
+    // Write an unsigned integer on a variable number of bytes: 7 bits per byte,
+    // the high bit telling if more bytes follow.
+    // Return the number of written bits.
+    inline unsigned writeVarint(uint32_t data) {
+        unsigned i_nbBits = 8;
+        for (; data >= 0x80; data >>= 7, i_nbBits += 8)
+            write((data & 0x7f) | 0x80, 8);
+        write(data, 8);
+        return i_nbBits;
+    }
+
+    // Write the pending bits, padded with zeros to a whole number of bytes.
+    void flush() {
+        while (i_nbPendingBits >= 8) {
+            i_nbPendingBits -= 8;
+            dbputbyte(p_buffer, i_bits >> i_nbPendingBits);
+        }
+        if (i_nbPendingBits > 0)
+            dbputbyte(p_buffer, i_bits << (8 - i_nbPendingBits));
+        i_nbPendingBits = 0;
+    }
+
+  private:
+    databuffer* p_buffer;
+    uint64_t i_bits;           // The lower i_nbPendingBits bits are not written yet.
+    unsigned i_nbPendingBits;  // Always less than 32 between two calls.
+};
+
+class BitReader {
+  public:
+    BitReader(databuffer* p_buffer) : p_buffer(p_buffer), i_bits(0), i_nbAvailableBits(0) {}
+
+    // Read i_nbBits (at most 32) bits.
+    inline uint32_t read(unsigned i_nbBits) {
+        assert(i_nbBits <= 32);
+
+        if (i_nbAvailableBits < i_nbBits)
+            refill();
+
+        i_nbAvailableBits -= i_nbBits;
+        return (i_bits >> i_nbAvailableBits) & (((uint64_t)1 << i_nbBits) - 1);
+    }
+
+    // Read an unsigned integer written by BitWriter::writeVarint().
+    inline uint32_t readVarint() {
+        uint32_t data = 0;
+        uint32_t byte;
+        unsigned i_shift = 0;
+        do {
+            byte = read(8);
+            data |= (byte & 0x7f) << i_shift;
+            i_shift += 7;
+        } while (byte & 0x80 && i_shift < 32);
+        return data;
+    }
+
+    // Give back the whole bytes that have been loaded but not read.
+    // The buffer offset is then just after the last read byte.
+    void finish() {
+        p_buffer->offset -= i_nbAvailableBits / 8;
+        i_nbAvailableBits = 0;
+    }
+
+  private:
+    // Load 4 more bytes in the accumulator.
+    // The bytes past the end of the valid data are read as 0.
+    inline void refill() {
+        assert(i_nbAvailableBits <= 32);
+
+        uint32_t word;
+        if (p_buffer->offset + sizeof(uint32_t) <= p_buffer->size) {
+            const unsigned char* p_src = (const unsigned char*)p_buffer->p_data + p_buffer->offset;
+            word = (uint32_t)p_src[0] << 24 | (uint32_t)p_src[1] << 16 | (uint32_t)p_src[2] << 8 | p_src[3];
+            p_buffer->offset += sizeof(uint32_t);
+        }
+        else {
+            word = 0;
+            for (unsigned i = 0; i < sizeof(uint32_t); ++i)
+                word = word << 8 | dbgetbyte(p_buffer);
+        }
+
+        i_bits = (i_bits << 32) | word;
+        i_nbAvailableBits += 32;
+    }
+
+    databuffer* p_buffer;
+    uint64_t i_bits;             // The lower i_nbAvailableBits bits are not read yet.
+    unsigned i_nbAvailableBits;  // At most 64.
+};
+
+#endif  // BITSTREAM_H
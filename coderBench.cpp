@@ -0,0 +1,296 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+/*
+  Entropy coder benchmark.
+
+  Codes symbol streams with the adaptive models of the codec and each
+  entropy coder, then decodes them and checks the result. The streams
+  are synthetic ones, for a range of alphabet sizes and total frequency
+  shifts, or the ones recorded by ppmc --record-symbols on real meshes.
+
+  For each stream and coder, the speeds are given in nanoseconds per
+  symbol and in megabytes per second of compressed data, the best of
+  several repetitions.
+
+  Usage: coderbench [symbol streams file...]
+*/
+
+#include "symbolStreams.h"
+
+#include "rangeCoder/binmodel.h"
+#include "rangeCoder/databuffer.h"
+#include "rangeCoder/qsmodel.h"
+#include "rangeCoder/rangecod.h"
+#include "rangeCoder/rans.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// Minimal number of repetitions and duration of the measure of a stream.
+#define BENCH_MIN_REPETITIONS 3
+#define BENCH_MIN_SECONDS 0.5
+
+// Number of symbols of the synthetic streams.
+#define SYNTHETIC_STREAM_LENGTH 1000000
+
+// The entropy coder of a benchmark, with the same interface for both coders as in the codec.
+struct BenchCoder {
+    bool b_useRans;
+    databuffer buffer;
+    rangecoder rangeCoder;
+    ranscoder ransCoder;
+};
+
+// The models of a stream, one per context.
+struct BenchModels {
+    std::vector<qsmodel> qsModels;
+    std::vector<binmodel> binModels;
+};
+
+static void initModels(BenchModels& models, const SymbolStream& stream, int b_compress) {
+    if (stream.i_nbSymbols == 2) {
+        models.binModels.resize(stream.i_nbContexts);
+        return;
+    }
+    models.qsModels.resize(stream.i_nbContexts);
+    for (qsmodel& model : models.qsModels)
+        initqsmodel(&model, stream.i_nbSymbols, stream.i_lgTotFreq, stream.i_rescale, NULL, b_compress);
+}
+
+static void resetModels(BenchModels& models) {
+    for (binmodel& model : models.binModels)
+        initbinmodel(&model);
+    for (qsmodel& model : models.qsModels)
+        resetqsmodel(&model, NULL);
+}
+
+static void deleteModels(BenchModels& models) {
+    for (qsmodel& model : models.qsModels)
+        deleteqsmodel(&model);
+}
+
+/**
+ * Encode a stream in the coder buffer.
+ * \return the number of bytes written.
+ */
+static size_t encodeStream(BenchCoder& coder, BenchModels& models, const SymbolStream& stream) {
+    coder.buffer.offset = 0;
+    coder.buffer.size = 0;
+    if (coder.b_useRans)
+        rans_start_encoding(&coder.ransCoder);
+    else
+        start_encoding(&coder.rangeCoder, 0, 0);
+
+    for (size_t i = 0; i < stream.symbols.size(); ++i) {
+        unsigned sym = stream.symbols[i];
+        int syfreq, ltfreq;
+        if (stream.i_nbSymbols == 2) {
+            binmodel* p_model = &models.binModels[stream.contexts[i]];
+            binmodelgetfreq(p_model, sym, &syfreq, &ltfreq);
+            binmodelupdate(p_model, sym);
+        }
+        else {
+            qsmodel* p_model = &models.qsModels[stream.contexts[i]];
+            qsgetfreq(p_model, sym, &syfreq, &ltfreq);
+            qsupdate(p_model, sym);
+        }
+
+        if (coder.b_useRans)
+            rans_encode_shift(&coder.ransCoder, syfreq, ltfreq, stream.i_lgTotFreq);
+        else
+            encode_shift(&coder.rangeCoder, syfreq, ltfreq, stream.i_lgTotFreq);
+    }
+
+    return coder.b_useRans ? rans_done_encoding(&coder.ransCoder) : done_encoding(&coder.rangeCoder);
+}
+
+/**
+ * Decode a stream from the coder buffer.
+ * \return the number of symbols different from the stream ones.
+ */
+static size_t decodeStream(BenchCoder& coder, BenchModels& models, const SymbolStream& stream) {
+    size_t i_nbErrors = 0;
+
+    coder.buffer.offset = 0;
+    if (coder.b_useRans)
+        rans_start_decoding(&coder.ransCoder, coder.buffer.size);
+    else
+        start_decoding(&coder.rangeCoder);
+
+    for (size_t i = 0; i < stream.symbols.size(); ++i) {
+        unsigned sym;
+        if (stream.i_nbSymbols == 2) {
+            binmodel* p_model = &models.binModels[stream.contexts[i]];
+            sym = coder.b_useRans ? rans_decode_bit_shift(&coder.ransCoder, *p_model, stream.i_lgTotFreq) :
+                                    decode_bit_shift(&coder.rangeCoder, *p_model, stream.i_lgTotFreq);
+            binmodelupdate(p_model, sym);
+        }
+        else {
+            qsmodel* p_model = &models.qsModels[stream.contexts[i]];
+            int syfreq, ltfreq;
+            if (coder.b_useRans) {
+                sym = qsgetsym(p_model, rans_decode_culshift(&coder.ransCoder, stream.i_lgTotFreq));
+                qsgetfreq(p_model, sym, &syfreq, &ltfreq);
+                rans_decode_update(&coder.ransCoder, syfreq, ltfreq, stream.i_lgTotFreq);
+            }
+            else {
+                sym = qsgetsym(p_model, decode_culshift(&coder.rangeCoder, stream.i_lgTotFreq));
+                qsgetfreq(p_model, sym, &syfreq, &ltfreq);
+                decode_update(&coder.rangeCoder, syfreq, ltfreq, 1 << stream.i_lgTotFreq);
+            }
+            qsupdate(p_model, sym);
+        }
+        i_nbErrors += sym != stream.symbols[i];
+    }
+
+    if (coder.b_useRans)
+        i_nbErrors += rans_done_decoding(&coder.ransCoder);
+    else
+        done_decoding(&coder.rangeCoder);
+
+    return i_nbErrors;
+}
+
+static double elapsedSeconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Measure the coding and decoding of a stream with a coder and print the results.
+ * \return false if the decoded symbols are not the stream ones.
+ */
+static bool benchStream(BenchCoder& coder, const SymbolStream& stream) {
+    BenchModels encModels, decModels;
+    initModels(encModels, stream, 1);
+    initModels(decModels, stream, 0);
+
+    size_t i_size = 0, i_nbErrors = 0;
+    double f_encSeconds = 1e30, f_decSeconds = 1e30, f_totalSeconds = 0;
+    for (unsigned i = 0; i < BENCH_MIN_REPETITIONS || f_totalSeconds < BENCH_MIN_SECONDS; ++i) {
+        resetModels(encModels);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        i_size = encodeStream(coder, encModels, stream);
+        double f_seconds = elapsedSeconds(start);
+        f_encSeconds = std::min(f_encSeconds, f_seconds);
+        f_totalSeconds += f_seconds;
+
+        resetModels(decModels);
+        start = std::chrono::steady_clock::now();
+        i_nbErrors += decodeStream(coder, decModels, stream);
+        f_seconds = elapsedSeconds(start);
+        f_decSeconds = std::min(f_decSeconds, f_seconds);
+        f_totalSeconds += f_seconds;
+    }
+
+    deleteModels(encModels);
+    deleteModels(decModels);
+
+    size_t i_nbSymbols = stream.symbols.size();
+    printf("%-12s %-6s %8u %5u %8u %10lu %8.3f %10.2f %8.1f %10.2f %8.1f\n", stream.name.c_str(),
+           coder.b_useRans ? "rANS" : "range", stream.i_nbSymbols, stream.i_lgTotFreq, stream.i_nbContexts,
+           (unsigned long)i_nbSymbols, i_size * 8.0 / i_nbSymbols, f_encSeconds * 1e9 / i_nbSymbols,
+           i_size / f_encSeconds / 1e6, f_decSeconds * 1e9 / i_nbSymbols, i_size / f_decSeconds / 1e6);
+
+    if (i_nbErrors != 0) {
+        printf("%lu symbols of the stream %s are decoded wrong.\n", (unsigned long)i_nbErrors, stream.name.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Build a synthetic stream of symbols with geometrically decreasing probabilities,
+ * so that each symbol is f_ratio times less likely than the previous one.
+ */
+static SymbolStream syntheticStream(unsigned i_nbSymbols, unsigned i_lgTotFreq, unsigned i_rescale, double f_ratio) {
+    SymbolStream stream;
+    char name[64];
+    snprintf(name, sizeof(name), "synthetic%u", i_nbSymbols);
+    stream.name = name;
+    stream.i_nbSymbols = i_nbSymbols;
+    stream.i_lgTotFreq = i_lgTotFreq;
+    stream.i_rescale = i_rescale;
+    stream.i_nbContexts = 1;
+
+    std::vector<double> cumProbabilities(i_nbSymbols);
+    double f_sum = 0, f_probability = 1;
+    for (unsigned i = 0; i < i_nbSymbols; ++i) {
+        f_sum += f_probability;
+        cumProbabilities[i] = f_sum;
+        f_probability *= f_ratio;
+    }
+
+    // A xorshift generator, so that the streams are the same on every platform.
+    uint32_t i_state = 2463534242u;
+    for (unsigned i = 0; i < SYNTHETIC_STREAM_LENGTH; ++i) {
+        i_state ^= i_state << 13;
+        i_state ^= i_state >> 17;
+        i_state ^= i_state << 5;
+        double f_value = i_state / 4294967296.0 * f_sum;
+        unsigned sym = std::upper_bound(cumProbabilities.begin(), cumProbabilities.end(), f_value) -
+                       cumProbabilities.begin();
+        stream.symbols.push_back(std::min(sym, i_nbSymbols - 1));
+        stream.contexts.push_back(0);
+    }
+
+    return stream;
+}
+
+int main(int argc, char** argv) {
+    std::vector<SymbolStream> streams;
+    if (argc < 2) {
+        // The alphabet sizes and shifts of the codec models.
+        streams.push_back(syntheticStream(2, BINMODEL_LG_TOTF, 0, 0.25));
+        streams.push_back(syntheticStream(8, 12, 2000, 0.5));
+        streams.push_back(syntheticStream(72, 12, 2000, 0.8));
+        streams.push_back(syntheticStream(8, 18, 1 << 17, 0.5));
+        streams.push_back(syntheticStream(72, 18, 1 << 17, 0.8));
+    }
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] == '-' || !readSymbolStreams(argv[i], streams)) {
+            printf("Can't read the symbol streams file %s.\nUsage: %s [symbol streams file...]\n", argv[i], argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    BenchCoder coder;
+    initdatabuffer(&coder.buffer);
+    coder.rangeCoder.p_buffer = &coder.buffer;
+    initranscoder(&coder.ransCoder, &coder.buffer);
+
+    printf("%-12s %-6s %8s %5s %8s %10s %8s %10s %8s %10s %8s\n", "stream", "coder", "alphabet", "shift", "contexts",
+           "symbols", "bits/sym", "enc ns/sym", "enc MB/s", "dec ns/sym", "dec MB/s");
+
+    bool b_ok = true;
+    for (const SymbolStream& stream : streams) {
+        for (bool b_useRans : {false, true}) {
+            coder.b_useRans = b_useRans;
+            b_ok = benchStream(coder, stream) && b_ok;
+        }
+    }
+
+    deleteranscoder(&coder.ransCoder);
+    deletedatabuffer(&coder.buffer);
+    return b_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
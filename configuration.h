@@ -20,13 +20,35 @@
 #ifndef CONFIGURATION_H
 #define CONFIGURATION_H
 
-// Size of the compressed data buffer.
-#define BUFFER_SIZE 10 * 1024 * 1024
-
 #define NB_BITS_FACE_DEGREE_BASE_MESH 3
 
 #define DECIMATION_OPERATION_ID 0
 #define QUANTIZATION_OPERATION_ID 1
+#define BASE_MESH_OPERATION_ID 2
+
+// Compressed file header: magic string and format version, followed by the level of detail index.
+#define FILE_MAGIC "PP3D"
+#define FILE_MAGIC_SIZE 4
+// The decoder only reads files of its own format version. Any change of the
+// bitstream layout must bump the version and add a line to this history:
+//  1: versioned header and LOD index.
+//  2: rANS coder flag.
+//  3: context-modelled binary connectivity symbols.
+//  4: per-LOD static residual tables.
+//  5: geometry residuals coded as a magnitude class plus raw bits.
+//  6: model priors id. The warm start flag was first written under this
+//     version without a bump, so version 6 files are ambiguous; like all
+//     older versions they are rejected.
+//  7: warm start flag and curvature/degree residual contexts.
+//  8: varint coded level of detail index.
+//  9: 2 bits entropy coder id instead of the rANS flag, for the 64 bits range coder.
+// 10: operation type and connectivity and geometry sizes in the level of detail index.
+// 11: rANS flag again instead of the entropy coder id, without the 64 bits range coder.
+#define FILE_FORMAT_VERSION 11
+#define FILE_HEADER_SIZE (FILE_MAGIC_SIZE + 1)
+
+// Base mesh face degree code that is followed by the rest of the degree.
+#define BASE_MESH_FACE_DEGREE_ESCAPE ((1 << NB_BITS_FACE_DEGREE_BASE_MESH) - 1)
 
 #define COMPRESSION_MODE_ID 0
 #define DECOMPRESSION_MODE_ID 1
@@ -34,6 +56,37 @@
 
 #define LIFTING_NB_ADDITIONAL_BITS_GEOMETRY 1
 
+/* Residual classes: the zigzag coded residuals lower than 1 << RESIDUAL_CLASS_DIRECT_BITS are their own class.
+   The class of the others is their number of bits and their RESIDUAL_CLASS_MANTISSA_BITS bits below the leading one,
+   their remaining low bits being coded without modelling. */
+#define RESIDUAL_CLASS_DIRECT_BITS 4
+#define RESIDUAL_CLASS_MANTISSA_BITS 1
+#define RESIDUAL_NB_CLASSES \
+    ((1 << RESIDUAL_CLASS_DIRECT_BITS) + ((32 - RESIDUAL_CLASS_DIRECT_BITS) << RESIDUAL_CLASS_MANTISSA_BITS))
+
+// Number of connectivity symbol contexts for each face degree class or edge
+// splittable face class: one without prediction and one per predictor,
+// predicted value and prediction strength.
+#define NB_FACE_PREDICTION_CONTEXTS (1 + 2 * 2 * 2)
+#define NB_FACE_CONNECT_CONTEXTS (3 * NB_FACE_PREDICTION_CONTEXTS)
+#define NB_EDGE_PREDICTION_CONTEXTS (1 + 2 * 2)
+#define NB_EDGE_CONNECT_CONTEXTS (2 * NB_EDGE_PREDICTION_CONTEXTS)
+
+// Number of geometry residual contexts: three curvature classes by two face degree classes.
+#define NB_RESIDUAL_CONTEXTS (3 * 2)
+
+// Number of symbols of the adaptive quantization model.
+#define QUANT_MODEL_NB_SYMBOLS 8
+
+// Id of the model priors used by default, 0 for uniform models.
+#define DEFAULT_MODEL_PRIORS_ID 1
+
+// Base 2 log of the total frequency of the static residual models.
+#define STATIC_MODEL_LG_TOTF 14
+
+// Fraction of removed element ids from which the mesh arrays are compacted before a level of detail.
+#define COMPACTION_MIN_REMOVED_FRACTION 0.25f
+
 #define INV_ALPHA 2
 #define INV_GAMMA 2
 
@@ -0,0 +1,99 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+/*
+  Corrupted compressed data test.
+
+  Compresses a torus with rANS, then decodes copies of the compressed
+  data with one bit flipped in the levels of detail. The decoding must
+  end, with an error or with a mesh, whatever the flipped bit is. A
+  corrupted rANS state used to make the decoder loop forever.
+
+  Usage: corrupteddatatest
+*/
+
+#include "ppmc.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Size of the torus grid.
+#define TORUS_NB_RINGS 48
+#define TORUS_NB_SECTIONS 24
+
+// Number of decoded copies with a flipped bit.
+#define NB_FLIPPED_BITS 300
+
+// Build a triangulated torus.
+static void buildTorus(std::vector<float>& vertices, std::vector<uint32_t>& faces) {
+    for (unsigned i = 0; i < TORUS_NB_RINGS; ++i) {
+        float u = 2 * M_PI * i / TORUS_NB_RINGS;
+        for (unsigned j = 0; j < TORUS_NB_SECTIONS; ++j) {
+            float v = 2 * M_PI * j / TORUS_NB_SECTIONS;
+            vertices.push_back((2 + cos(v)) * cos(u));
+            vertices.push_back((2 + cos(v)) * sin(u));
+            vertices.push_back(sin(v));
+        }
+    }
+
+    for (unsigned i = 0; i < TORUS_NB_RINGS; ++i) {
+        for (unsigned j = 0; j < TORUS_NB_SECTIONS; ++j) {
+            uint32_t a = i * TORUS_NB_SECTIONS + j;
+            uint32_t b = i * TORUS_NB_SECTIONS + (j + 1) % TORUS_NB_SECTIONS;
+            uint32_t c = (i + 1) % TORUS_NB_RINGS * TORUS_NB_SECTIONS + j;
+            uint32_t d = (i + 1) % TORUS_NB_RINGS * TORUS_NB_SECTIONS + (j + 1) % TORUS_NB_SECTIONS;
+            uint32_t triangles[] = {3, a, c, d, 3, a, d, b};
+            faces.insert(faces.end(), triangles, triangles + 8);
+        }
+    }
+}
+
+int main() {
+    std::vector<float> vertices, decodedVertices;
+    std::vector<uint32_t> faces, decodedFaces;
+    buildTorus(vertices, faces);
+
+    PPMCOptions options;
+    options.b_useRans = true;
+    std::vector<char> data;
+    if (!ppmcCompress(vertices, faces, options, data)) {
+        printf("The torus can not be compressed.\n");
+        return EXIT_FAILURE;
+    }
+
+    if (ppmcDecompress(data.data(), data.size(), -1, decodedVertices, decodedFaces) < 0 ||
+        decodedVertices.size() != vertices.size()) {
+        printf("The torus is not decoded back.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Flip bits in the second half of the data, which holds the finest levels of detail.
+    size_t i_start = data.size() / 2;
+    unsigned i_nbErrors = 0;
+    for (unsigned i = 0; i < NB_FLIPPED_BITS; ++i) {
+        std::vector<char> corruptedData(data);
+        size_t i_bit = i_start * 8 + (size_t)i * 2654435761u % ((data.size() - i_start) * 8);
+        corruptedData[i_bit / 8] ^= 1 << (i_bit % 8);
+        i_nbErrors += ppmcDecompress(corruptedData.data(), corruptedData.size(), -1, decodedVertices, decodedFaces) < 0;
+    }
+
+    printf("%u of the %u corrupted copies are reported invalid.\n", i_nbErrors, NB_FLIPPED_BITS);
+    return EXIT_SUCCESS;
+}
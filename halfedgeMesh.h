@@ -0,0 +1,1046 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef HALFEDGEMESH_H
+#define HALFEDGEMESH_H
+
+/*
+  Halfedge mesh stored in arrays indexed by 32-bit ids.
+
+  The connectivity, the vertex positions and the data of each kind of
+  element are in separate arrays, so that the conquests only load what they
+  use. The two halfedges of an edge are stored side by side: the opposite of
+  the halfedge h is h ^ 1.
+
+  The handles have the interface of the CGAL polyhedron handles the codec
+  was written with, e.g. h->next()->opposite()->vertex()->point(). The items
+  give the point type, the data of each kind of element, the data shared by
+  all the elements and the handle mixins that access them.
+
+  The removed elements are only marked, and the new ones are appended: the
+  iteration order is the creation order, like with the list based CGAL
+  polyhedron, until reorder() sets another one.
+*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <unordered_map>
+#include <vector>
+
+// Id of no element, e.g. the face of a border halfedge.
+#define HALFEDGE_MESH_NULL_ID 0xffffffff
+// Id stored in the arrays for the removed elements.
+#define HALFEDGE_MESH_REMOVED_ID 0xfffffffe
+
+template <class Items> class HalfedgeMesh;
+template <class Items> class HalfedgeMeshHalfedgeHandle;
+template <class Items> class HalfedgeMeshFacetCirculator;
+template <class Items> class HalfedgeMeshVertexCirculator;
+
+// Vertex handle, which is also the vertex iterator.
+template <class Items>
+class HalfedgeMeshVertexHandle : public Items::template Vertex<HalfedgeMeshVertexHandle<Items>> {
+    typedef HalfedgeMesh<Items> Mesh;
+
+  public:
+    HalfedgeMeshVertexHandle() : p_mesh(NULL), i_id(HALFEDGE_MESH_NULL_ID) {}
+
+    HalfedgeMeshVertexHandle(Mesh* p_mesh, uint32_t i_id) : p_mesh(p_mesh), i_id(i_id) {}
+
+    inline const HalfedgeMeshVertexHandle* operator->() const {
+        return this;
+    }
+
+    inline uint32_t id() const {
+        return i_id;
+    }
+
+    inline typename Items::Point_3& point() const {
+        return p_mesh->vertexPoints[i_id];
+    }
+
+    inline typename Items::Vertex_data& data() const {
+        return p_mesh->vertexData[i_id];
+    }
+
+    inline typename Items::Mesh_data& mesh_data() const {
+        return p_mesh->meshData;
+    }
+
+    inline HalfedgeMeshHalfedgeHandle<Items> halfedge() const {
+        return HalfedgeMeshHalfedgeHandle<Items>(p_mesh, p_mesh->vertexHalfedges[i_id]);
+    }
+
+    inline HalfedgeMeshVertexCirculator<Items> vertex_begin() const {
+        return halfedge();
+    }
+
+    inline size_t vertex_degree() const {
+        return halfedge()->vertex_degree();
+    }
+
+    // Move to the next vertex that is not removed.
+    inline HalfedgeMeshVertexHandle& operator++() {
+        do
+            i_id++;
+        while (i_id < p_mesh->vertexHalfedges.size() && p_mesh->vertexHalfedges[i_id] == HALFEDGE_MESH_REMOVED_ID);
+        return *this;
+    }
+
+    inline HalfedgeMeshVertexHandle operator++(int) {
+        HalfedgeMeshVertexHandle it = *this;
+        ++*this;
+        return it;
+    }
+
+    inline bool operator==(const HalfedgeMeshVertexHandle& v) const {
+        return i_id == v.i_id;
+    }
+
+    inline bool operator!=(const HalfedgeMeshVertexHandle& v) const {
+        return i_id != v.i_id;
+    }
+
+    inline bool operator<(const HalfedgeMeshVertexHandle& v) const {
+        return i_id < v.i_id;
+    }
+
+  private:
+    Mesh* p_mesh;
+    uint32_t i_id;
+};
+
+// Face handle, which is also the face iterator.
+template <class Items>
+class HalfedgeMeshFaceHandle : public Items::template Face<HalfedgeMeshFaceHandle<Items>> {
+    typedef HalfedgeMesh<Items> Mesh;
+
+  public:
+    HalfedgeMeshFaceHandle() : p_mesh(NULL), i_id(HALFEDGE_MESH_NULL_ID) {}
+
+    HalfedgeMeshFaceHandle(Mesh* p_mesh, uint32_t i_id) : p_mesh(p_mesh), i_id(i_id) {}
+
+    inline const HalfedgeMeshFaceHandle* operator->() const {
+        return this;
+    }
+
+    inline uint32_t id() const {
+        return i_id;
+    }
+
+    inline typename Items::Face_data& data() const {
+        return p_mesh->faceData[i_id];
+    }
+
+    inline typename Items::Mesh_data& mesh_data() const {
+        return p_mesh->meshData;
+    }
+
+    inline HalfedgeMeshHalfedgeHandle<Items> halfedge() const {
+        return HalfedgeMeshHalfedgeHandle<Items>(p_mesh, p_mesh->faceHalfedges[i_id]);
+    }
+
+    inline HalfedgeMeshFacetCirculator<Items> facet_begin() const {
+        return halfedge();
+    }
+
+    inline size_t facet_degree() const {
+        return halfedge()->facet_degree();
+    }
+
+    inline bool is_triangle() const {
+        return facet_degree() == 3;
+    }
+
+    // Move to the next face that is not removed.
+    inline HalfedgeMeshFaceHandle& operator++() {
+        do
+            i_id++;
+        while (i_id < p_mesh->faceHalfedges.size() && p_mesh->faceHalfedges[i_id] == HALFEDGE_MESH_REMOVED_ID);
+        return *this;
+    }
+
+    inline HalfedgeMeshFaceHandle operator++(int) {
+        HalfedgeMeshFaceHandle it = *this;
+        ++*this;
+        return it;
+    }
+
+    inline bool operator==(const HalfedgeMeshFaceHandle& f) const {
+        return i_id == f.i_id;
+    }
+
+    inline bool operator!=(const HalfedgeMeshFaceHandle& f) const {
+        return i_id != f.i_id;
+    }
+
+    inline bool operator<(const HalfedgeMeshFaceHandle& f) const {
+        return i_id < f.i_id;
+    }
+
+  private:
+    Mesh* p_mesh;
+    uint32_t i_id;
+};
+
+// Halfedge handle, which is also the halfedge iterator.
+template <class Items>
+class HalfedgeMeshHalfedgeHandle : public Items::template Halfedge<HalfedgeMeshHalfedgeHandle<Items>> {
+    typedef HalfedgeMesh<Items> Mesh;
+
+  public:
+    HalfedgeMeshHalfedgeHandle() : p_mesh(NULL), i_id(HALFEDGE_MESH_NULL_ID) {}
+
+    HalfedgeMeshHalfedgeHandle(Mesh* p_mesh, uint32_t i_id) : p_mesh(p_mesh), i_id(i_id) {}
+
+    inline const HalfedgeMeshHalfedgeHandle* operator->() const {
+        return this;
+    }
+
+    inline uint32_t id() const {
+        return i_id;
+    }
+
+    inline typename Items::Halfedge_data& data() const {
+        return p_mesh->halfedgeData[i_id];
+    }
+
+    inline typename Items::Mesh_data& mesh_data() const {
+        return p_mesh->meshData;
+    }
+
+    inline HalfedgeMeshHalfedgeHandle opposite() const {
+        return HalfedgeMeshHalfedgeHandle(p_mesh, i_id ^ 1);
+    }
+
+    inline HalfedgeMeshHalfedgeHandle next() const {
+        return HalfedgeMeshHalfedgeHandle(p_mesh, p_mesh->halfedgeNexts[i_id]);
+    }
+
+    inline HalfedgeMeshHalfedgeHandle prev() const {
+        return HalfedgeMeshHalfedgeHandle(p_mesh, p_mesh->halfedgePrevs[i_id]);
+    }
+
+    // Vertex the halfedge points to.
+    inline HalfedgeMeshVertexHandle<Items> vertex() const {
+        return HalfedgeMeshVertexHandle<Items>(p_mesh, p_mesh->halfedgeVertices[i_id]);
+    }
+
+    inline HalfedgeMeshFaceHandle<Items> facet() const {
+        return HalfedgeMeshFaceHandle<Items>(p_mesh, p_mesh->halfedgeFaces[i_id]);
+    }
+
+    inline HalfedgeMeshFaceHandle<Items> face() const {
+        return facet();
+    }
+
+    inline bool is_border() const {
+        return p_mesh->halfedgeFaces[i_id] == HALFEDGE_MESH_NULL_ID;
+    }
+
+    inline HalfedgeMeshFacetCirculator<Items> facet_begin() const {
+        return *this;
+    }
+
+    inline HalfedgeMeshVertexCirculator<Items> vertex_begin() const {
+        return *this;
+    }
+
+    size_t facet_degree() const {
+        size_t i_degree = 0;
+        uint32_t h = i_id;
+        do {
+            i_degree++;
+            h = p_mesh->halfedgeNexts[h];
+        } while (h != i_id);
+        return i_degree;
+    }
+
+    // Degree of the vertex the halfedge points to.
+    size_t vertex_degree() const {
+        size_t i_degree = 0;
+        uint32_t h = i_id;
+        do {
+            i_degree++;
+            h = p_mesh->halfedgeNexts[h] ^ 1;
+        } while (h != i_id);
+        return i_degree;
+    }
+
+    inline bool is_triangle() const {
+        return facet_degree() == 3;
+    }
+
+    // Move to the next halfedge that is not removed.
+    inline HalfedgeMeshHalfedgeHandle& operator++() {
+        do
+            i_id++;
+        while (i_id < p_mesh->halfedgeVertices.size() && p_mesh->halfedgeVertices[i_id] == HALFEDGE_MESH_REMOVED_ID);
+        return *this;
+    }
+
+    inline HalfedgeMeshHalfedgeHandle operator++(int) {
+        HalfedgeMeshHalfedgeHandle it = *this;
+        ++*this;
+        return it;
+    }
+
+    inline bool operator==(const HalfedgeMeshHalfedgeHandle& h) const {
+        return i_id == h.i_id;
+    }
+
+    inline bool operator!=(const HalfedgeMeshHalfedgeHandle& h) const {
+        return i_id != h.i_id;
+    }
+
+    inline bool operator<(const HalfedgeMeshHalfedgeHandle& h) const {
+        return i_id < h.i_id;
+    }
+
+  protected:
+    Mesh* p_mesh;
+    uint32_t i_id;
+};
+
+// Circulator on the halfedges of a face.
+template <class Items> class HalfedgeMeshFacetCirculator : public HalfedgeMeshHalfedgeHandle<Items> {
+    typedef HalfedgeMeshHalfedgeHandle<Items> Handle;
+
+  public:
+    HalfedgeMeshFacetCirculator() {}
+
+    HalfedgeMeshFacetCirculator(const Handle& h) : Handle(h) {}
+
+    inline HalfedgeMeshFacetCirculator& operator++() {
+        this->i_id = this->p_mesh->halfedgeNexts[this->i_id];
+        return *this;
+    }
+
+    inline HalfedgeMeshFacetCirculator operator++(int) {
+        HalfedgeMeshFacetCirculator c = *this;
+        ++*this;
+        return c;
+    }
+
+    inline HalfedgeMeshFacetCirculator& operator--() {
+        this->i_id = this->p_mesh->halfedgePrevs[this->i_id];
+        return *this;
+    }
+};
+
+// Circulator on the halfedges pointing to a vertex, clockwise.
+template <class Items> class HalfedgeMeshVertexCirculator : public HalfedgeMeshHalfedgeHandle<Items> {
+    typedef HalfedgeMeshHalfedgeHandle<Items> Handle;
+
+  public:
+    HalfedgeMeshVertexCirculator() {}
+
+    HalfedgeMeshVertexCirculator(const Handle& h) : Handle(h) {}
+
+    inline HalfedgeMeshVertexCirculator& operator++() {
+        this->i_id = this->p_mesh->halfedgeNexts[this->i_id] ^ 1;
+        return *this;
+    }
+
+    inline HalfedgeMeshVertexCirculator operator++(int) {
+        HalfedgeMeshVertexCirculator c = *this;
+        ++*this;
+        return c;
+    }
+
+    inline HalfedgeMeshVertexCirculator& operator--() {
+        this->i_id = this->p_mesh->halfedgePrevs[this->i_id ^ 1];
+        return *this;
+    }
+};
+
+template <class Items> class HalfedgeMesh {
+    friend class HalfedgeMeshVertexHandle<Items>;
+    friend class HalfedgeMeshHalfedgeHandle<Items>;
+    friend class HalfedgeMeshFaceHandle<Items>;
+    friend class HalfedgeMeshFacetCirculator<Items>;
+    friend class HalfedgeMeshVertexCirculator<Items>;
+
+  public:
+    typedef typename Items::Point_3 Point_3;
+    typedef typename Items::Vertex_data Vertex_data;
+    typedef typename Items::Halfedge_data Halfedge_data;
+    typedef typename Items::Face_data Face_data;
+    typedef typename Items::Mesh_data Mesh_data;
+
+    // The handles do not make the difference between the constant elements and the others.
+    typedef HalfedgeMeshVertexHandle<Items> Vertex_handle;
+    typedef Vertex_handle Vertex_const_handle;
+    typedef Vertex_handle Vertex_iterator;
+    typedef Vertex_handle Vertex_const_iterator;
+    typedef HalfedgeMeshHalfedgeHandle<Items> Halfedge_handle;
+    typedef Halfedge_handle Halfedge_const_handle;
+    typedef Halfedge_handle Halfedge_iterator;
+    typedef Halfedge_handle Halfedge_const_iterator;
+    typedef HalfedgeMeshFaceHandle<Items> Face_handle;
+    typedef Face_handle Face_const_handle;
+    typedef Face_handle Face_iterator;
+    typedef Face_handle Face_const_iterator;
+    typedef Face_handle Facet_handle;
+    typedef Face_handle Facet_const_handle;
+    typedef Face_handle Facet_iterator;
+    typedef Face_handle Facet_const_iterator;
+    typedef HalfedgeMeshFacetCirculator<Items> Halfedge_around_facet_circulator;
+    typedef HalfedgeMeshFacetCirculator<Items> Halfedge_around_facet_const_circulator;
+    typedef HalfedgeMeshVertexCirculator<Items> Halfedge_around_vertex_circulator;
+    typedef HalfedgeMeshVertexCirculator<Items> Halfedge_around_vertex_const_circulator;
+    typedef size_t size_type;
+
+    HalfedgeMesh() : i_sizeOfVertices(0), i_sizeOfHalfedges(0), i_sizeOfFacets(0) {}
+
+    HalfedgeMesh(const HalfedgeMesh&) = delete;
+
+    HalfedgeMesh& operator=(const HalfedgeMesh&) = delete;
+
+    /* Iterators */
+
+    Vertex_iterator vertices_begin() const {
+        uint32_t v = 0;
+        while (v < vertexHalfedges.size() && vertexHalfedges[v] == HALFEDGE_MESH_REMOVED_ID)
+            v++;
+        return Vertex_iterator(self(), v);
+    }
+
+    Vertex_iterator vertices_end() const {
+        return Vertex_iterator(self(), vertexHalfedges.size());
+    }
+
+    Halfedge_iterator halfedges_begin() const {
+        uint32_t h = 0;
+        while (h < halfedgeVertices.size() && halfedgeVertices[h] == HALFEDGE_MESH_REMOVED_ID)
+            h++;
+        return Halfedge_iterator(self(), h);
+    }
+
+    Halfedge_iterator halfedges_end() const {
+        return Halfedge_iterator(self(), halfedgeVertices.size());
+    }
+
+    Face_iterator facets_begin() const {
+        uint32_t f = 0;
+        while (f < faceHalfedges.size() && faceHalfedges[f] == HALFEDGE_MESH_REMOVED_ID)
+            f++;
+        return Face_iterator(self(), f);
+    }
+
+    Face_iterator facets_end() const {
+        return Face_iterator(self(), faceHalfedges.size());
+    }
+
+    size_type size_of_vertices() const {
+        return i_sizeOfVertices;
+    }
+
+    size_type size_of_halfedges() const {
+        return i_sizeOfHalfedges;
+    }
+
+    size_type size_of_facets() const {
+        return i_sizeOfFacets;
+    }
+
+    // Size of the arrays indexed by the element ids, which include the removed elements.
+
+    size_type size_of_vertex_ids() const {
+        return vertexHalfedges.size();
+    }
+
+    size_type size_of_halfedge_ids() const {
+        return halfedgeVertices.size();
+    }
+
+    size_type size_of_facet_ids() const {
+        return faceHalfedges.size();
+    }
+
+    void reserve(size_type i_nbVertices, size_type i_nbHalfedges, size_type i_nbFaces) {
+        vertexHalfedges.reserve(i_nbVertices);
+        vertexPoints.reserve(i_nbVertices);
+        vertexData.reserve(i_nbVertices);
+        halfedgeNexts.reserve(i_nbHalfedges);
+        halfedgePrevs.reserve(i_nbHalfedges);
+        halfedgeVertices.reserve(i_nbHalfedges);
+        halfedgeFaces.reserve(i_nbHalfedges);
+        halfedgeData.reserve(i_nbHalfedges);
+        faceHalfedges.reserve(i_nbFaces);
+        faceData.reserve(i_nbFaces);
+    }
+
+    void clear() {
+        vertexHalfedges.clear();
+        vertexPoints.clear();
+        vertexData.clear();
+        halfedgeNexts.clear();
+        halfedgePrevs.clear();
+        halfedgeVertices.clear();
+        halfedgeFaces.clear();
+        halfedgeData.clear();
+        faceHalfedges.clear();
+        faceData.clear();
+        i_sizeOfVertices = i_sizeOfHalfedges = i_sizeOfFacets = 0;
+    }
+
+    bool is_closed() const {
+        for (uint32_t h = 0; h < halfedgeVertices.size(); ++h)
+            if (halfedgeVertices[h] != HALFEDGE_MESH_REMOVED_ID && halfedgeFaces[h] == HALFEDGE_MESH_NULL_ID)
+                return false;
+        return true;
+    }
+
+    bool is_pure_triangle() const {
+        for (Face_iterator fit = facets_begin(); fit != facets_end(); ++fit)
+            if (fit->facet_degree() != 3)
+                return false;
+        return true;
+    }
+
+    /**
+     * Test if the faces around each vertex form a single fan and no face visits a vertex twice.
+     * Isolated vertices and edges whose ends are the same vertex are rejected. The mesh must be closed.
+     */
+    bool is_manifold() const {
+        std::vector<uint32_t> nbIncomingHalfedges(vertexHalfedges.size(), 0);
+        for (uint32_t h = 0; h < halfedgeVertices.size(); ++h) {
+            if (halfedgeVertices[h] == HALFEDGE_MESH_REMOVED_ID)
+                continue;
+            if (halfedgeVertices[h] == halfedgeVertices[h ^ 1])
+                return false;
+            nbIncomingHalfedges[halfedgeVertices[h]]++;
+        }
+
+        // The fan of the halfedge of a vertex must contain all the halfedges pointing to it.
+        for (uint32_t v = 0; v < vertexHalfedges.size(); ++v) {
+            uint32_t hFirst = vertexHalfedges[v];
+            if (hFirst == HALFEDGE_MESH_REMOVED_ID)
+                continue;
+            if (hFirst == HALFEDGE_MESH_NULL_ID)
+                return false;
+            uint32_t i_nbFanHalfedges = 0, h = hFirst;
+            do {
+                i_nbFanHalfedges++;
+                h = halfedgeNexts[h] ^ 1;
+            } while (h != hFirst && i_nbFanHalfedges <= nbIncomingHalfedges[v]);
+            if (i_nbFanHalfedges != nbIncomingHalfedges[v])
+                return false;
+        }
+
+        std::vector<uint32_t> lastFaces(vertexHalfedges.size(), HALFEDGE_MESH_NULL_ID);
+        for (uint32_t f = 0; f < faceHalfedges.size(); ++f) {
+            uint32_t hFirst = faceHalfedges[f];
+            if (hFirst == HALFEDGE_MESH_REMOVED_ID)
+                continue;
+            uint32_t h = hFirst;
+            do {
+                uint32_t v = halfedgeVertices[h];
+                if (lastFaces[v] == f)
+                    return false;
+                lastFaces[v] = f;
+                h = halfedgeNexts[h];
+            } while (h != hFirst);
+        }
+        return true;
+    }
+
+    /**
+     * Build the mesh from vertex and face arrays.
+     * \param vertices the x, y and z coordinates of each vertex.
+     * \param faces for each face, its number of vertices followed by their ids.
+     * \return false, with an empty mesh, if a vertex id is wrong or if an edge is shared
+     * by more than two faces or by two faces with opposite orientations.
+     */
+    bool build(const std::vector<float>& vertices, const std::vector<uint32_t>& faces) {
+        clear();
+
+        // Reserve the elements, the border halfedges excepted.
+        size_t i_nbVertices = vertices.size() / 3;
+        size_t i_nbFaces = 0, i_nbFaceHalfedges = 0;
+        for (size_t i = 0; i < faces.size(); i += faces[i] + 1) {
+            i_nbFaces++;
+            i_nbFaceHalfedges += faces[i];
+        }
+        reserve(i_nbVertices, i_nbFaceHalfedges, i_nbFaces);
+
+        for (size_t i = 0; i < i_nbVertices; ++i)
+            newVertex(Point_3(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]), Vertex_data());
+
+        // Halfedges of the edges that only have one face yet, by their vertices.
+        std::unordered_map<uint64_t, uint32_t> borderHalfedges;
+
+        for (size_t i = 0; i < faces.size(); i += faces[i] + 1) {
+            unsigned i_degree = faces[i];
+            const uint32_t* p_face = &faces[i + 1];
+
+            uint32_t f = newFace(Face_data());
+            uint32_t hFirst = HALFEDGE_MESH_NULL_ID, hPrev = HALFEDGE_MESH_NULL_ID;
+            for (unsigned j = 0; j < i_degree; ++j) {
+                uint32_t a = p_face[j], b = p_face[(j + 1) % i_degree];
+                uint32_t h;
+
+                if (a >= i_nbVertices || b >= i_nbVertices) {
+                    clear();
+                    return false;
+                }
+
+                std::unordered_map<uint64_t, uint32_t>::iterator it = borderHalfedges.find((uint64_t)b << 32 | a);
+                if (it != borderHalfedges.end()) {
+                    h = it->second ^ 1;
+                    borderHalfedges.erase(it);
+                }
+                else {
+                    h = newEdge();
+                    halfedgeVertices[h ^ 1] = a;
+                    if (!borderHalfedges.insert(std::make_pair((uint64_t)a << 32 | b, h)).second) {
+                        clear();
+                        return false;
+                    }
+                }
+
+                halfedgeVertices[h] = b;
+                halfedgeFaces[h] = f;
+                vertexHalfedges[b] = h;
+
+                if (j == 0)
+                    hFirst = h;
+                else
+                    link(hPrev, h);
+                hPrev = h;
+            }
+            link(hPrev, hFirst);
+            faceHalfedges[f] = hFirst;
+        }
+
+        // The remaining halfedges of the border are left without face and not linked.
+        return true;
+    }
+
+    /* Euler operations */
+
+    /**
+     * Split the face of h and g by a new edge between their vertices.
+     * \return the new halfedge that points to the vertex of g, in the face of h.
+     */
+    Halfedge_handle split_facet(Halfedge_handle hh, Halfedge_handle gh) {
+        uint32_t h = hh.id(), g = gh.id();
+        assert(halfedgeFaces[h] == halfedgeFaces[g] && h != g && halfedgeNexts[h] != g && halfedgeNexts[g] != h);
+
+        uint32_t fOld = halfedgeFaces[h];
+        uint32_t hNew = newEdge(), hOpp = hNew ^ 1;
+        uint32_t fNew = newFace(faceData[fOld]);
+        uint32_t gNext = halfedgeNexts[g], hNext = halfedgeNexts[h];
+
+        halfedgeVertices[hNew] = halfedgeVertices[g];
+        halfedgeVertices[hOpp] = halfedgeVertices[h];
+        link(h, hNew);
+        link(hNew, gNext);
+        link(g, hOpp);
+        link(hOpp, hNext);
+
+        halfedgeFaces[hNew] = fOld;
+        uint32_t it = hOpp;
+        do {
+            halfedgeFaces[it] = fNew;
+            it = halfedgeNexts[it];
+        } while (it != hOpp);
+
+        faceHalfedges[fOld] = h;
+        faceHalfedges[fNew] = hOpp;
+
+        return Halfedge_handle(this, hNew);
+    }
+
+    /**
+     * Remove the vertex of h and its incident edges. Its faces are merged in the face of h.
+     * \return the halfedge that preceded h in its face.
+     */
+    Halfedge_handle erase_center_vertex(Halfedge_handle hh) {
+        uint32_t h = hh.id();
+        uint32_t v = halfedgeVertices[h];
+        uint32_t fKeep = halfedgeFaces[h];
+        uint32_t hRet = halfedgePrevs[h];
+
+        // Halfedges pointing to the vertex.
+        std::vector<uint32_t>& in = tmpHalfedges;
+        in.clear();
+        uint32_t g = h;
+        do {
+            in.push_back(g);
+            g = halfedgeNexts[g] ^ 1;
+        } while (g != h);
+
+        size_t n = in.size();
+        tmpPrevs.resize(n);
+        tmpNexts.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            tmpPrevs[i] = halfedgePrevs[in[i]];
+            tmpNexts[i] = halfedgeNexts[halfedgeNexts[in[i]]];
+            assert(halfedgeNexts[in[i]] == (in[(i + 1) % n] ^ 1));
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            link(tmpPrevs[i], tmpNexts[(i + n - 1) % n]);
+            vertexHalfedges[halfedgeVertices[tmpPrevs[i]]] = tmpPrevs[i];
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            if (halfedgeFaces[in[i]] != fKeep)
+                removeFace(halfedgeFaces[in[i]]);
+        }
+        for (size_t i = 0; i < n; ++i)
+            removeEdge(in[i]);
+        removeVertex(v);
+
+        uint32_t it = hRet;
+        do {
+            halfedgeFaces[it] = fKeep;
+            it = halfedgeNexts[it];
+        } while (it != hRet);
+        faceHalfedges[fKeep] = hRet;
+
+        return Halfedge_handle(this, hRet);
+    }
+
+    /**
+     * Split the face of h by a new vertex linked to each of its vertices.
+     * The new vertex and faces are copies of the vertex of h and of the face of h.
+     * \return the new halfedge that points to the new vertex, after h.
+     */
+    Halfedge_handle create_center_vertex(Halfedge_handle hh) {
+        uint32_t h = hh.id();
+        uint32_t f = halfedgeFaces[h];
+
+        std::vector<uint32_t>& e = tmpHalfedges;
+        e.clear();
+        uint32_t it = h;
+        do {
+            e.push_back(it);
+            it = halfedgeNexts[it];
+        } while (it != h);
+
+        size_t n = e.size();
+        uint32_t vNew = newVertex(vertexPoints[halfedgeVertices[h]], vertexData[halfedgeVertices[h]]);
+
+        // The halfedges a[i] = tmpPrevs[i] point to the new vertex, their opposite to the vertex of e[i].
+        std::vector<uint32_t>& a = tmpPrevs;
+        a.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            a[i] = newEdge();
+            halfedgeVertices[a[i]] = vNew;
+            halfedgeVertices[a[i] ^ 1] = halfedgeVertices[e[i]];
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t bPrev = a[(i + n - 1) % n] ^ 1;
+            uint32_t fi = i == 0 ? f : newFace(faceData[f]);
+            link(e[i], a[i]);
+            link(a[i], bPrev);
+            link(bPrev, e[i]);
+            halfedgeFaces[e[i]] = fi;
+            halfedgeFaces[a[i]] = fi;
+            halfedgeFaces[bPrev] = fi;
+            faceHalfedges[fi] = e[i];
+        }
+        vertexHalfedges[vNew] = a[0];
+
+        return Halfedge_handle(this, a[0]);
+    }
+
+    /**
+     * Remove the edge of h and merge its two faces in the face of h.
+     * \return the halfedge that preceded h in its face.
+     */
+    Halfedge_handle join_facet(Halfedge_handle hh) {
+        uint32_t h = hh.id(), g = h ^ 1;
+        uint32_t fKeep = halfedgeFaces[h], fRemoved = halfedgeFaces[g];
+        assert(fKeep != fRemoved);
+
+        uint32_t hPrev = halfedgePrevs[h], gPrev = halfedgePrevs[g];
+        uint32_t hNext = halfedgeNexts[h], gNext = halfedgeNexts[g];
+
+        for (uint32_t it = gNext; it != g; it = halfedgeNexts[it])
+            halfedgeFaces[it] = fKeep;
+
+        link(hPrev, gNext);
+        link(gPrev, hNext);
+
+        if (vertexHalfedges[halfedgeVertices[h]] == h)
+            vertexHalfedges[halfedgeVertices[h]] = gPrev;
+        if (vertexHalfedges[halfedgeVertices[g]] == g)
+            vertexHalfedges[halfedgeVertices[g]] = hPrev;
+        faceHalfedges[fKeep] = hPrev;
+
+        removeFace(fRemoved);
+        removeEdge(h);
+
+        return Halfedge_handle(this, hPrev);
+    }
+
+    /**
+     * Remove all the connected components but the one with the most vertices.
+     * \return the number of removed components.
+     */
+    unsigned keep_largest_connected_components(unsigned i_nbComponentsToKeep) {
+        assert(i_nbComponentsToKeep == 1);
+
+        // Union-find of the vertices along the edges.
+        std::vector<uint32_t> roots(vertexHalfedges.size());
+        for (uint32_t v = 0; v < roots.size(); ++v)
+            roots[v] = v;
+        for (uint32_t h = 0; h < halfedgeVertices.size(); h += 2) {
+            if (halfedgeVertices[h] == HALFEDGE_MESH_REMOVED_ID)
+                continue;
+            uint32_t r1 = findRoot(roots, halfedgeVertices[h]);
+            uint32_t r2 = findRoot(roots, halfedgeVertices[h + 1]);
+            if (r1 != r2)
+                roots[r1 > r2 ? r1 : r2] = r1 > r2 ? r2 : r1;
+        }
+
+        // Number the components in the vertex order and count their vertices.
+        std::vector<uint32_t> components(vertexHalfedges.size(), HALFEDGE_MESH_NULL_ID);
+        std::vector<size_t> sizes;
+        for (Vertex_iterator vit = vertices_begin(); vit != vertices_end(); ++vit) {
+            uint32_t r = findRoot(roots, vit.id());
+            if (components[r] == HALFEDGE_MESH_NULL_ID) {
+                components[r] = sizes.size();
+                sizes.push_back(0);
+            }
+            components[vit.id()] = components[r];
+            sizes[components[r]]++;
+        }
+
+        if (sizes.size() <= 1)
+            return 0;
+
+        uint32_t i_largest = 0;
+        for (uint32_t i = 1; i < sizes.size(); ++i)
+            if (sizes[i] > sizes[i_largest])
+                i_largest = i;
+
+        for (Face_iterator fit = facets_begin(); fit != facets_end(); ++fit) {
+            if (components[halfedgeVertices[faceHalfedges[fit.id()]]] != i_largest)
+                removeFace(fit.id());
+        }
+        for (Halfedge_iterator hit = halfedges_begin(); hit != halfedges_end(); ++hit) {
+            if (components[halfedgeVertices[hit.id()]] != i_largest && (hit.id() & 1) == 0)
+                removeEdge(hit.id());
+        }
+        for (Vertex_iterator vit = vertices_begin(); vit != vertices_end(); ++vit) {
+            if (components[vit.id()] != i_largest)
+                removeVertex(vit.id());
+        }
+
+        return sizes.size() - 1;
+    }
+
+    /* Reorder the elements and drop the removed ones. The vectors give the ids of
+       the vertices, edges and faces that are not removed, in their new order. The
+       edge e is made of the halfedges 2e and 2e + 1, which keep their order.
+       The handles on the elements are no longer valid. */
+    void reorder(const std::vector<uint32_t>& vertexIds,
+                 const std::vector<uint32_t>& edgeIds,
+                 const std::vector<uint32_t>& faceIds) {
+        assert(vertexIds.size() == i_sizeOfVertices && edgeIds.size() * 2 == i_sizeOfHalfedges &&
+               faceIds.size() == i_sizeOfFacets);
+
+        std::vector<uint32_t> halfedgeIds(edgeIds.size() * 2);
+        for (size_t i = 0; i < edgeIds.size(); ++i) {
+            halfedgeIds[i * 2] = edgeIds[i] * 2;
+            halfedgeIds[i * 2 + 1] = edgeIds[i] * 2 + 1;
+        }
+
+        // New id of each old id.
+        std::vector<uint32_t> newVertexIds(vertexHalfedges.size(), HALFEDGE_MESH_REMOVED_ID);
+        for (size_t i = 0; i < vertexIds.size(); ++i)
+            newVertexIds[vertexIds[i]] = i;
+        std::vector<uint32_t> newHalfedgeIds(halfedgeVertices.size(), HALFEDGE_MESH_REMOVED_ID);
+        for (size_t i = 0; i < halfedgeIds.size(); ++i)
+            newHalfedgeIds[halfedgeIds[i]] = i;
+        std::vector<uint32_t> newFaceIds(faceHalfedges.size(), HALFEDGE_MESH_REMOVED_ID);
+        for (size_t i = 0; i < faceIds.size(); ++i)
+            newFaceIds[faceIds[i]] = i;
+
+        gather(vertexHalfedges, vertexIds, newHalfedgeIds);
+        gather(vertexPoints, vertexIds);
+        gather(vertexData, vertexIds);
+
+        gather(halfedgeNexts, halfedgeIds, newHalfedgeIds);
+        gather(halfedgePrevs, halfedgeIds, newHalfedgeIds);
+        gather(halfedgeVertices, halfedgeIds, newVertexIds);
+        gather(halfedgeFaces, halfedgeIds, newFaceIds);
+        gather(halfedgeData, halfedgeIds);
+
+        gather(faceHalfedges, faceIds, newHalfedgeIds);
+        gather(faceData, faceIds);
+    }
+
+    // Fraction of the element ids that belong to removed elements.
+    float removed_fraction() const {
+        size_t i_nbIds = vertexHalfedges.size() + halfedgeVertices.size() + faceHalfedges.size();
+        if (i_nbIds == 0)
+            return 0;
+        return 1 - (float)(i_sizeOfVertices + i_sizeOfHalfedges + i_sizeOfFacets) / i_nbIds;
+    }
+
+    /* Drop the removed elements and keep the order of the others, so that the
+       iterations visit them in the same order. newVertexIds gives the new id of
+       each old vertex id. The handles on the elements are no longer valid. */
+    void compact(std::vector<uint32_t>& newVertexIds) {
+        std::vector<uint32_t> vertexIds, edgeIds, faceIds;
+        vertexIds.reserve(i_sizeOfVertices);
+        edgeIds.reserve(i_sizeOfHalfedges / 2);
+        faceIds.reserve(i_sizeOfFacets);
+
+        newVertexIds.assign(vertexHalfedges.size(), HALFEDGE_MESH_REMOVED_ID);
+        for (uint32_t v = 0; v < vertexHalfedges.size(); ++v) {
+            if (vertexHalfedges[v] != HALFEDGE_MESH_REMOVED_ID) {
+                newVertexIds[v] = vertexIds.size();
+                vertexIds.push_back(v);
+            }
+        }
+        for (uint32_t h = 0; h < halfedgeVertices.size(); h += 2)
+            if (halfedgeVertices[h] != HALFEDGE_MESH_REMOVED_ID)
+                edgeIds.push_back(h >> 1);
+        for (uint32_t f = 0; f < faceHalfedges.size(); ++f)
+            if (faceHalfedges[f] != HALFEDGE_MESH_REMOVED_ID)
+                faceIds.push_back(f);
+
+        reorder(vertexIds, edgeIds, faceIds);
+    }
+
+  protected:
+    // Connectivity and positions of the vertices.
+    std::vector<uint32_t> vertexHalfedges;  // A halfedge pointing to each vertex.
+    std::vector<Point_3> vertexPoints;
+    std::vector<Vertex_data> vertexData;
+
+    // Connectivity of the halfedges.
+    std::vector<uint32_t> halfedgeNexts;
+    std::vector<uint32_t> halfedgePrevs;
+    std::vector<uint32_t> halfedgeVertices;  // Vertex each halfedge points to.
+    std::vector<uint32_t> halfedgeFaces;
+    std::vector<Halfedge_data> halfedgeData;
+
+    // Connectivity of the faces.
+    std::vector<uint32_t> faceHalfedges;
+    std::vector<Face_data> faceData;
+
+    // Data shared by all the elements.
+    Mesh_data meshData;
+
+    // Number of elements that are not removed.
+    size_t i_sizeOfVertices;
+    size_t i_sizeOfHalfedges;
+    size_t i_sizeOfFacets;
+
+  private:
+    inline HalfedgeMesh* self() const {
+        return const_cast<HalfedgeMesh*>(this);
+    }
+
+    // Replace an array by its values at the given ids.
+    template <class T> static void gather(std::vector<T>& values, const std::vector<uint32_t>& ids) {
+        std::vector<T> newValues(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i)
+            newValues[i] = values[ids[i]];
+        values.swap(newValues);
+    }
+
+    // Same, for an array of ids, which are also replaced by their new value.
+    static void gather(std::vector<uint32_t>& values,
+                       const std::vector<uint32_t>& ids,
+                       const std::vector<uint32_t>& newIds) {
+        std::vector<uint32_t> newValues(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i) {
+            uint32_t id = values[ids[i]];
+            newValues[i] = id == HALFEDGE_MESH_NULL_ID ? id : newIds[id];
+        }
+        values.swap(newValues);
+    }
+
+    inline void link(uint32_t h, uint32_t hNext) {
+        halfedgeNexts[h] = hNext;
+        halfedgePrevs[hNext] = h;
+    }
+
+    inline uint32_t newVertex(const Point_3& p, const Vertex_data& data) {
+        vertexHalfedges.push_back(HALFEDGE_MESH_NULL_ID);
+        vertexPoints.push_back(p);
+        vertexData.push_back(data);
+        i_sizeOfVertices++;
+        return vertexHalfedges.size() - 1;
+    }
+
+    // Append the two halfedges of a new edge, without connectivity.
+    inline uint32_t newEdge() {
+        for (unsigned i = 0; i < 2; ++i) {
+            halfedgeNexts.push_back(HALFEDGE_MESH_NULL_ID);
+            halfedgePrevs.push_back(HALFEDGE_MESH_NULL_ID);
+            halfedgeVertices.push_back(HALFEDGE_MESH_NULL_ID);
+            halfedgeFaces.push_back(HALFEDGE_MESH_NULL_ID);
+            halfedgeData.push_back(Halfedge_data());
+        }
+        i_sizeOfHalfedges += 2;
+        return halfedgeVertices.size() - 2;
+    }
+
+    inline uint32_t newFace(const Face_data& data) {
+        faceHalfedges.push_back(HALFEDGE_MESH_NULL_ID);
+        faceData.push_back(data);
+        i_sizeOfFacets++;
+        return faceHalfedges.size() - 1;
+    }
+
+    inline void removeVertex(uint32_t v) {
+        vertexHalfedges[v] = HALFEDGE_MESH_REMOVED_ID;
+        i_sizeOfVertices--;
+    }
+
+    // Remove the edge of the halfedge h.
+    inline void removeEdge(uint32_t h) {
+        halfedgeVertices[h] = HALFEDGE_MESH_REMOVED_ID;
+        halfedgeVertices[h ^ 1] = HALFEDGE_MESH_REMOVED_ID;
+        i_sizeOfHalfedges -= 2;
+    }
+
+    inline void removeFace(uint32_t f) {
+        faceHalfedges[f] = HALFEDGE_MESH_REMOVED_ID;
+        i_sizeOfFacets--;
+    }
+
+    static uint32_t findRoot(std::vector<uint32_t>& roots, uint32_t v) {
+        while (roots[v] != v) {
+            roots[v] = roots[roots[v]];
+            v = roots[v];
+        }
+        return v;
+    }
+
+    // Temporary arrays of the Euler operations.
+    std::vector<uint32_t> tmpHalfedges;
+    std::vector<uint32_t> tmpPrevs;
+    std::vector<uint32_t> tmpNexts;
+};
+
+#endif  // HALFEDGEMESH_H
@@ -0,0 +1,107 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+/*
+  Level of detail index test.
+
+  Compresses a torus with adaptive quantization and reads back the
+  level of detail index. The entries must describe the base mesh, then
+  each operation, and their sizes must cover the compressed data.
+
+  Usage: lodindextest
+*/
+
+#include "ppmc.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Size of the torus grid.
+#define TORUS_NB_RINGS 48
+#define TORUS_NB_SECTIONS 24
+
+// Build a triangulated torus.
+static void buildTorus(std::vector<float>& vertices, std::vector<uint32_t>& faces) {
+    for (unsigned i = 0; i < TORUS_NB_RINGS; ++i) {
+        float u = 2 * M_PI * i / TORUS_NB_RINGS;
+        for (unsigned j = 0; j < TORUS_NB_SECTIONS; ++j) {
+            float v = 2 * M_PI * j / TORUS_NB_SECTIONS;
+            vertices.push_back((2 + cos(v)) * cos(u));
+            vertices.push_back((2 + cos(v)) * sin(u));
+            vertices.push_back(sin(v));
+        }
+    }
+
+    for (unsigned i = 0; i < TORUS_NB_RINGS; ++i) {
+        for (unsigned j = 0; j < TORUS_NB_SECTIONS; ++j) {
+            uint32_t a = i * TORUS_NB_SECTIONS + j;
+            uint32_t b = i * TORUS_NB_SECTIONS + (j + 1) % TORUS_NB_SECTIONS;
+            uint32_t c = (i + 1) % TORUS_NB_RINGS * TORUS_NB_SECTIONS + j;
+            uint32_t d = (i + 1) % TORUS_NB_RINGS * TORUS_NB_SECTIONS + (j + 1) % TORUS_NB_SECTIONS;
+            uint32_t triangles[] = {3, a, c, d, 3, a, d, b};
+            faces.insert(faces.end(), triangles, triangles + 8);
+        }
+    }
+}
+
+int main() {
+    std::vector<float> vertices;
+    std::vector<uint32_t> faces;
+    buildTorus(vertices, faces);
+
+    PPMCOptions options;
+    options.b_useAdaptiveQuantization = true;
+    std::vector<char> data;
+    std::vector<PPMCLodInfo> lods;
+    if (!ppmcCompress(vertices, faces, options, data) || !ppmcReadLodIndex(data.data(), data.size(), lods)) {
+        printf("The level of detail index can not be read.\n");
+        return EXIT_FAILURE;
+    }
+
+    unsigned i_nbQuantizations = 0;
+    uint64_t i_offset = lods[0].i_offset;
+    for (unsigned i = 0; i < lods.size(); ++i) {
+        const PPMCLodInfo& lod = lods[i];
+        // Base mesh first, then decimations (0) and adaptive quantizations (1).
+        bool b_validOperation = i == 0 ? lod.i_operationType == 2 : lod.i_operationType <= 1;
+        if (!b_validOperation || lod.i_offset != i_offset ||
+            lod.i_connectivitySize + lod.i_geometrySize > lod.i_size * 8) {
+            printf("The entry of the level of detail %u is invalid.\n", i);
+            return EXIT_FAILURE;
+        }
+        i_nbQuantizations += lod.i_operationType == 1;
+        i_offset += lod.i_size;
+    }
+
+    if (i_offset != data.size() || i_nbQuantizations == 0 ||
+        lods.back().i_nbVertices != vertices.size() / 3 || lods.back().i_nbFaces != faces.size() / 4) {
+        printf("The level of detail index does not describe the compressed torus.\n");
+        return EXIT_FAILURE;
+    }
+
+    // A truncated index is not read.
+    if (ppmcReadLodIndex(data.data(), lods[0].i_offset - 1, lods)) {
+        printf("A truncated level of detail index is read.\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%u levels of detail, %u of them adaptive quantizations.\n", (unsigned)lods.size(), i_nbQuantizations);
+    return EXIT_SUCCESS;
+}
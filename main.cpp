@@ -113,6 +113,15 @@ static const char *const GUIhelp[] =
 //global variables
 MyMesh *currentMesh = NULL;
 
+// Print why the job of the current mesh was stopped, once.
+static void printMeshError() {
+    static bool b_printed = false;
+    if (currentMesh->hasError() && !b_printed) {
+        printf("%s\n", currentMesh->getErrorMessage().c_str());
+        b_printed = true;
+    }
+}
+
 
 static void SavePPM(char *FileName, unsigned char *Colour, int Width, int Height) {
     FILE *fp = fopen(FileName, "wb");
@@ -243,14 +252,17 @@ void myKeyboard(unsigned char Key, int x, int y) {
             break;
         case 's':
             currentMesh->stepOperation();
+            printMeshError();
             glutPostRedisplay();
             break;
         case 'b':
             currentMesh->batchOperation();
+            printMeshError();
             glutPostRedisplay();
             break;
         case 'B':
             currentMesh->completeOperation();
+            printMeshError();
             glutPostRedisplay();
             break;
         case '?':
@@ -539,14 +551,14 @@ void printUsage() {
     fprintf(stderr, "Usage: ppmc [mode] [options] <filepath>\n"
                     "\n"
                     "Mode:\n"
-                    "   -c : compression (default mode if none is specified).\n"
+                    "   -c : compression (default mode if none is specified). The input mesh is an OFF or a PLY file.\n"
                     "   -d <percentage> : decompression at a given percentage. Use -o option to set the output file name.\n"
                     "   -D <percentage> : same as -d but write all the intermediate levels of details decompressed files.\n"
                     "   -h : display this usage message.\n"
                     "\n"
                     "Options:\n"
                     "   --gui : display the GUI.\n"
-                    "   -o <filepath> : set the output file name for the compression or the decompression.\n"
+                    "   -o <filepath> : set the output file name for the compression or the decompression. The extension of a decompressed mesh file name sets its format: .off (default), .ply (binary PLY) or .raw (raw arrays).\n"
                     "   -q <quantization> : set the number of quantization bits. The default value is 12.\n"
                     "   --enable-adaptive-quantization : enable the adaptive quantization scheme. Should be used with --disable-lifting-scheme.\n"
                     "   --disable-lifting-scheme : disable the lifting scheme.\n"
@@ -554,6 +566,12 @@ void printUsage() {
                     "   --disable-connectivity-prediction-faces : disable the connectivity prediction scheme for the faces.\n"
                     "   --disable-triangle-mesh-connectivity-prediction-faces : disable the connectivity prediction scheme for the faces of the triangular meshes.\n"
                     "   --disable-connectivity-prediction-edges : disable the connectivity prediction scheme for the edges.\n"
+                    "   --enable-rans : code the symbols with rANS instead of the range coder. Faster to decode.\n"
+                    "   --enable-static-tables : use static residual models for the levels of detail they compress almost as well. Faster to decode.\n"
+                    "   --enable-warm-start : start the models of each level of detail from the ones of the previous level.\n"
+                    "   --model-priors <id> : set the trained priors of the models. 0 starts the models uniform. The default value is 1.\n"
+                    "   --train-priors <filepath> : add the model symbol counts of the compression to a file, to compile new model priors.\n"
+                    "   --record-symbols <filepath> : write the symbols given to the models during the compression in a file, for the coder benchmark.\n"
                     "   --forbid-concave-faces : forbid during the first part of the compression to generate concave faces.\n");
 }
 
@@ -572,6 +590,12 @@ int main(int argc, char **argv) {
     bool b_useConnectivityPredictionEdges = true;
     bool b_allowConcaveFaces = true;
     bool b_useTriangleMeshConnectivityPredictionFaces = true;
+    bool b_useRans = false;
+    bool b_useStaticTables = false;
+    bool b_useWarmStart = false;
+    unsigned i_modelPriorsId = DEFAULT_MODEL_PRIORS_ID;
+    char *psz_modelCountsFilePath = NULL;
+    char *psz_symbolStreamsFilePath = NULL;
     unsigned i_quantBit = 12;
     unsigned i_decompPercentage = 100;
 
@@ -661,6 +685,33 @@ int main(int argc, char **argv) {
             } else if (!strcmp(argv[i], "--disable-connectivity-prediction-edges")) {
                 EXIT_IF_LAST_ARGUMENT()
                 b_useConnectivityPredictionEdges = false;
+            } else if (!strcmp(argv[i], "--enable-rans")) {
+                EXIT_IF_LAST_ARGUMENT()
+                b_useRans = true;
+            } else if (!strcmp(argv[i], "--enable-static-tables")) {
+                EXIT_IF_LAST_ARGUMENT()
+                b_useStaticTables = true;
+            } else if (!strcmp(argv[i], "--enable-warm-start")) {
+                EXIT_IF_LAST_ARGUMENT()
+                b_useWarmStart = true;
+            } else if (!strcmp(argv[i], "--model-priors")) {
+                if (i >= argc - 2) {
+                    printUsage();
+                    return EXIT_FAILURE;
+                }
+                i_modelPriorsId = atoi(argv[++i]);
+            } else if (!strcmp(argv[i], "--train-priors")) {
+                if (i >= argc - 2) {
+                    printUsage();
+                    return EXIT_FAILURE;
+                }
+                psz_modelCountsFilePath = argv[++i];
+            } else if (!strcmp(argv[i], "--record-symbols")) {
+                if (i >= argc - 2) {
+                    printUsage();
+                    return EXIT_FAILURE;
+                }
+                psz_symbolStreamsFilePath = argv[++i];
             } else if (!strcmp(argv[i], "--forbid-concave-faces")) {
                 EXIT_IF_LAST_ARGUMENT()
                 b_allowConcaveFaces = false;
@@ -681,8 +732,6 @@ int main(int argc, char **argv) {
     if (i_mode != COMPRESSION_MODE_ID) {
         if (filePathOutput == "")
             filePathOutput = std::string("out");
-        if (filePathOutput.find(".off") == filePathOutput.length() - 4)
-            filePathOutput = filePathOutput.substr(0, filePathOutput.length() - 4);
     } else {
         if (filePathOutput == "")
             filePathOutput = std::string("out.pp3d");
@@ -698,7 +747,18 @@ int main(int argc, char **argv) {
                              i_mode, i_quantBit, b_useAdaptiveQuantization,
                              b_useLiftingScheme, b_useCurvaturePrediction,
                              b_useConnectivityPredictionFaces, b_useConnectivityPredictionEdges,
-                             b_allowConcaveFaces, b_useTriangleMeshConnectivityPredictionFaces);
+                             b_allowConcaveFaces, b_useTriangleMeshConnectivityPredictionFaces, b_useRans,
+                             b_useStaticTables, i_modelPriorsId,
+                             b_useWarmStart, true);
+    if (currentMesh->hasError()) {
+        printMeshError();
+        return EXIT_FAILURE;
+    }
+
+    if (psz_modelCountsFilePath != NULL && i_mode == COMPRESSION_MODE_ID)
+        currentMesh->trainModelPriors(psz_modelCountsFilePath);
+    if (psz_symbolStreamsFilePath != NULL && i_mode == COMPRESSION_MODE_ID)
+        currentMesh->recordSymbolStreams(psz_symbolStreamsFilePath);
 
     if (b_displayGUI) {
         // Configure the view.
@@ -740,6 +800,7 @@ int main(int argc, char **argv) {
         currentMesh->completeOperation();
     }
 
-    return EXIT_SUCCESS;
+    printMeshError();
+    return currentMesh->hasError() ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
@@ -0,0 +1,364 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "meshReader.h"
+#include "rangeCoder/databuffer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+// Skip the white spaces and the comments.
+static inline void skipSpaces(const char*& p, const char* end) {
+    while (p < end) {
+        if (*p == '#') {
+            while (p < end && *p != '\n')
+                ++p;
+        }
+        else if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+            ++p;
+        else
+            break;
+    }
+}
+
+// Skip the end of the current line.
+static inline void skipLine(const char*& p, const char* end) {
+    while (p < end && *p != '\n')
+        ++p;
+}
+
+// Parse a number in the text.
+template <class T> static inline bool parseNumber(const char*& p, const char* end, T& value) {
+    skipSpaces(p, end);
+    std::from_chars_result res = std::from_chars(p, end, value);
+    if (res.ec != std::errc())
+        return false;
+    p = res.ptr;
+    return true;
+}
+
+// Parse a word in the text.
+static std::string parseWord(const char*& p, const char* end) {
+    skipSpaces(p, end);
+    const char* p_begin = p;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+        ++p;
+    return std::string(p_begin, p);
+}
+
+// Read the vertices and the faces of an OFF file.
+static bool readOff(const char* p, const char* end, std::vector<float>& vertices, std::vector<uint32_t>& faces,
+                    std::string& error) {
+    // Accept the header variants that only add data at the end of the lines (COFF, NOFF, STOFF...).
+    std::string header = parseWord(p, end);
+    if (header.size() < 3 || header.compare(header.size() - 3, 3, "OFF") != 0 ||
+        header.find_first_of("4n") != std::string::npos) {
+        error = "unsupported OFF header '" + header + "'";
+        return false;
+    }
+
+    size_t i_nbVertices, i_nbFaces, i_nbEdges;
+    if (!parseNumber(p, end, i_nbVertices) || !parseNumber(p, end, i_nbFaces) || !parseNumber(p, end, i_nbEdges))
+        return false;
+
+    // Each element takes at least two characters. The counts are tested one by one, so that their sum
+    // can not overflow.
+    size_t i_maxNbElements = (size_t)(end - p) / 2;
+    if (i_nbVertices > i_maxNbElements || i_nbFaces > i_maxNbElements - i_nbVertices)
+        return false;
+
+    vertices.resize(i_nbVertices * 3);
+    for (size_t i = 0; i < i_nbVertices; ++i) {
+        // The coordinates are parsed in double precision, as the CGAL reader does.
+        double coord[3];
+        for (unsigned j = 0; j < 3; ++j) {
+            if (!parseNumber(p, end, coord[j]))
+                return false;
+            vertices[i * 3 + j] = coord[j];
+        }
+        skipLine(p, end);
+    }
+
+    faces.clear();
+    faces.reserve(i_nbFaces * 4);
+    for (size_t i = 0; i < i_nbFaces; ++i) {
+        uint32_t i_degree;
+        if (!parseNumber(p, end, i_degree))
+            return false;
+        faces.push_back(i_degree);
+        for (unsigned j = 0; j < i_degree; ++j) {
+            uint32_t i_vertexId;
+            if (!parseNumber(p, end, i_vertexId))
+                return false;
+            faces.push_back(i_vertexId);
+        }
+        skipLine(p, end);
+    }
+
+    return true;
+}
+
+// PLY scalar types.
+enum PlyType { PlyChar, PlyUChar, PlyShort, PlyUShort, PlyInt, PlyUInt, PlyFloat, PlyDouble, PlyUnknown };
+
+static const unsigned plyTypeSizes[] = {1, 1, 2, 2, 4, 4, 4, 8};
+
+static PlyType plyTypeFromName(const std::string& name) {
+    static const char* names[][2] = {{"char", "int8"},    {"uchar", "uint8"}, {"short", "int16"},
+                                     {"ushort", "uint16"}, {"int", "int32"},   {"uint", "uint32"},
+                                     {"float", "float32"}, {"double", "float64"}};
+    for (unsigned i = 0; i < PlyUnknown; ++i) {
+        if (name == names[i][0] || name == names[i][1])
+            return (PlyType)i;
+    }
+    return PlyUnknown;
+}
+
+struct PlyProperty {
+    PlyType type;       // Type of the value or of the list items.
+    PlyType countType;  // Type of the list item count, PlyUnknown if the property is not a list.
+    std::string name;
+};
+
+struct PlyElement {
+    std::string name;
+    size_t i_count;
+    std::vector<PlyProperty> properties;
+};
+
+// Read a binary PLY value.
+static inline bool readPlyBinary(const char*& p, const char* end, PlyType type, bool b_swap, double& value) {
+    unsigned i_size = plyTypeSizes[type];
+    if (end - p < (ptrdiff_t)i_size)
+        return false;
+
+    unsigned char bytes[8];
+    memcpy(bytes, p, i_size);
+    p += i_size;
+    if (b_swap) {
+        for (unsigned i = 0; i < i_size / 2; ++i) {
+            unsigned char c = bytes[i];
+            bytes[i] = bytes[i_size - 1 - i];
+            bytes[i_size - 1 - i] = c;
+        }
+    }
+
+    switch (type) {
+        case PlyChar: value = *(int8_t*)bytes; break;
+        case PlyUChar: value = *(uint8_t*)bytes; break;
+        case PlyShort: value = *(int16_t*)bytes; break;
+        case PlyUShort: value = *(uint16_t*)bytes; break;
+        case PlyInt: value = *(int32_t*)bytes; break;
+        case PlyUInt: value = *(uint32_t*)bytes; break;
+        case PlyFloat: value = *(float*)bytes; break;
+        case PlyDouble: value = *(double*)bytes; break;
+        default: return false;
+    }
+    return true;
+}
+
+/**
+ * Convert a PLY value to an integer count or id.
+ * \return false if the value is negative, not a number or above max, as its cast would be undefined.
+ */
+template <class T> static inline bool plyValueToInteger(double value, T max, T& i) {
+    if (!(value >= 0 && value <= (double)max))
+        return false;
+    i = (T)value;
+    return true;
+}
+
+// Read the vertices and the faces of a PLY file.
+static bool readPly(const char* p, const char* end, std::vector<float>& vertices, std::vector<uint32_t>& faces,
+                    std::string& error) {
+    enum { Ascii, BinaryLittleEndian, BinaryBigEndian } format = Ascii;
+    std::vector<PlyElement> elements;
+
+    // Parse the header.
+    skipLine(p, end);
+    for (;;) {
+        std::string keyword = parseWord(p, end);
+        if (keyword == "end_header") {
+            skipLine(p, end);
+            if (p < end)
+                ++p;
+            break;
+        }
+        else if (keyword == "format") {
+            std::string name = parseWord(p, end);
+            if (name == "binary_little_endian")
+                format = BinaryLittleEndian;
+            else if (name == "binary_big_endian")
+                format = BinaryBigEndian;
+            else if (name != "ascii") {
+                error = "unsupported PLY format '" + name + "'";
+                return false;
+            }
+        }
+        else if (keyword == "element") {
+            PlyElement element;
+            element.name = parseWord(p, end);
+            if (!parseNumber(p, end, element.i_count))
+                return false;
+            elements.push_back(element);
+        }
+        else if (keyword == "property") {
+            if (elements.empty())
+                return false;
+            PlyProperty property;
+            std::string typeName = parseWord(p, end);
+            property.countType = PlyUnknown;
+            if (typeName == "list") {
+                property.countType = plyTypeFromName(parseWord(p, end));
+                typeName = parseWord(p, end);
+                if (property.countType == PlyUnknown)
+                    return false;
+            }
+            property.type = plyTypeFromName(typeName);
+            property.name = parseWord(p, end);
+            if (property.type == PlyUnknown) {
+                error = "unsupported PLY property type '" + typeName + "'";
+                return false;
+            }
+            elements.back().properties.push_back(property);
+        }
+        else if (keyword.empty())
+            return false;
+        skipLine(p, end);
+    }
+
+    bool b_swap = false;
+    if (format != Ascii) {
+        uint16_t i_one = 1;
+        bool b_littleEndianHost = *(unsigned char*)&i_one == 1;
+        b_swap = b_littleEndianHost != (format == BinaryLittleEndian);
+    }
+
+    // Parse the body.
+    vertices.clear();
+    faces.clear();
+    for (unsigned i = 0; i < elements.size(); ++i) {
+        const PlyElement& element = elements[i];
+        bool b_isVertex = element.name == "vertex";
+        bool b_isFace = element.name == "face";
+
+        // Position of the used properties.
+        int coordIds[3] = {-1, -1, -1};
+        int i_indexId = -1;
+        for (unsigned j = 0; j < element.properties.size(); ++j) {
+            const PlyProperty& property = element.properties[j];
+            if (b_isVertex && property.name.size() == 1 && property.name[0] >= 'x' && property.name[0] <= 'z')
+                coordIds[property.name[0] - 'x'] = j;
+            else if (b_isFace && property.countType != PlyUnknown &&
+                     (property.name == "vertex_indices" || property.name == "vertex_index"))
+                i_indexId = j;
+        }
+        if (b_isVertex && (coordIds[0] < 0 || coordIds[1] < 0 || coordIds[2] < 0))
+            return false;
+        if (b_isFace && i_indexId < 0)
+            return false;
+
+        // Check the count against the remaining data before allocating: each property takes at least
+        // one value of two characters in ASCII, the last one may miss its separator, or of its type
+        // size in binary. An element without property is counted as one byte, which bounds the loop below.
+        size_t i_minElementSize = 0;
+        for (unsigned j = 0; j < element.properties.size(); ++j) {
+            const PlyProperty& property = element.properties[j];
+            PlyType firstType = property.countType != PlyUnknown ? property.countType : property.type;
+            i_minElementSize += format == Ascii ? 2 : plyTypeSizes[firstType];
+        }
+        if (element.i_count > (size_t)(end - p + (format == Ascii)) / std::max<size_t>(i_minElementSize, 1))
+            return false;
+
+        if (b_isVertex)
+            vertices.resize(element.i_count * 3);
+        if (b_isFace)
+            faces.reserve(element.i_count * 4);
+
+        for (size_t k = 0; k < element.i_count; ++k) {
+            for (unsigned j = 0; j < element.properties.size(); ++j) {
+                const PlyProperty& property = element.properties[j];
+                double value;
+                size_t i_nbValues = 1;
+
+                if (property.countType != PlyUnknown) {
+                    if (format == Ascii ? !parseNumber(p, end, value)
+                                        : !readPlyBinary(p, end, property.countType, b_swap, value))
+                        return false;
+                    // Each value takes at least one character or byte.
+                    if (!plyValueToInteger(value, std::min<size_t>(end - p, UINT32_MAX), i_nbValues))
+                        return false;
+                    if ((int)j == i_indexId)
+                        faces.push_back(i_nbValues);
+                }
+
+                for (size_t l = 0; l < i_nbValues; ++l) {
+                    if (format == Ascii ? !parseNumber(p, end, value)
+                                        : !readPlyBinary(p, end, property.type, b_swap, value))
+                        return false;
+                    if ((int)j == i_indexId) {
+                        uint32_t i_vertexId;
+                        if (!plyValueToInteger(value, (uint32_t)UINT32_MAX, i_vertexId))
+                            return false;
+                        faces.push_back(i_vertexId);
+                    }
+                    else if (b_isVertex) {
+                        for (unsigned c = 0; c < 3; ++c) {
+                            if ((int)j == coordIds[c])
+                                vertices[k * 3 + c] = value;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool readMeshFile(const char psz_filePath[], std::vector<float>& vertices, std::vector<uint32_t>& faces,
+                  std::string& error) {
+    databuffer file;
+    initdatabuffer(&file);
+    if (mapdatabuffer(&file, psz_filePath) != 0) {
+        error = std::string("Can't read the mesh file '") + psz_filePath + "'.";
+        return false;
+    }
+
+    const char* p = file.p_data;
+    const char* end = file.p_data + file.size;
+
+    std::string reason;
+    bool b_ret;
+    if (file.size >= 3 && memcmp(p, "ply", 3) == 0)
+        b_ret = readPly(p, end, vertices, faces, reason);
+    else
+        b_ret = readOff(p, end, vertices, faces, reason);
+
+    if (!b_ret) {
+        error = std::string("Can't parse the mesh file '") + psz_filePath + "'";
+        error += reason.empty() ? "." : ": " + reason + ".";
+    }
+
+    deletedatabuffer(&file);
+    return b_ret;
+}
@@ -0,0 +1,38 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef MESHREADER_H
+#define MESHREADER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Read a mesh from an OFF file or a PLY file (ASCII or binary).
+ * The file is mapped in memory and parsed in one pass.
+ * \param vertices the x, y and z coordinates of each vertex.
+ * \param faces for each face, its number of vertices followed by their ids.
+ * \param error the reason why the file can not be read.
+ * \return false if the file can not be read.
+ */
+bool readMeshFile(const char psz_filePath[], std::vector<float>& vertices, std::vector<uint32_t>& faces,
+                  std::string& error);
+
+#endif  // MESHREADER_H
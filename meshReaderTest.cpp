@@ -0,0 +1,163 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+/*
+  PLY reader test.
+
+  Reads a valid tetrahedron, then copies of it whose list counts or
+  vertex indices are negative, not numbers or too large for their
+  integer type, in ASCII and in binary. These must be rejected instead
+  of being cast to undefined counts and ids.
+
+  Usage: meshreadertest [temporary file path]
+*/
+
+#include "meshReader.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+static const char* psz_asciiHeader =
+    "ply\nformat ascii 1.0\nelement vertex 4\nproperty float x\nproperty float y\nproperty float z\n"
+    "element face 4\nproperty list uchar int vertex_indices\nend_header\n"
+    "0 0 0\n1 0 0\n0 1 0\n0 0 1\n";
+
+static const char* psz_binaryHeader =
+    "ply\nformat binary_little_endian 1.0\nelement vertex 4\nproperty float x\nproperty float y\nproperty float z\n"
+    "element face 1\nproperty list int float vertex_indices\nend_header\n";
+
+// Set when a file is not read without an error message.
+static bool b_missingError = false;
+
+// Write a file and read it as a mesh.
+static bool readData(const char* psz_filePath, const std::string& data, std::vector<float>& vertices,
+                     std::vector<uint32_t>& faces) {
+    FILE* p_file = fopen(psz_filePath, "wb");
+    if (p_file == NULL) {
+        printf("Can't write the file %s.\n", psz_filePath);
+        return false;
+    }
+    fwrite(data.data(), 1, data.size(), p_file);
+    fclose(p_file);
+
+    std::string error;
+    if (readMeshFile(psz_filePath, vertices, faces, error))
+        return true;
+
+    if (error.empty()) {
+        printf("No error is reported for the unread file %s.\n", psz_filePath);
+        b_missingError = true;
+    }
+    return false;
+}
+
+// Append a little endian 32 bits value.
+static void appendLittleEndian(std::string& data, uint32_t v) {
+    for (unsigned i = 0; i < 4; ++i)
+        data.push_back((char)(v >> (8 * i)));
+}
+
+static void appendFloat(std::string& data, float f) {
+    uint32_t v;
+    memcpy(&v, &f, sizeof(v));
+    appendLittleEndian(data, v);
+}
+
+// Binary tetrahedron vertices followed by a face with the given count and indices.
+static std::string binaryFace(int32_t i_count, const float* indices, unsigned i_nbIndices) {
+    std::string data = psz_binaryHeader;
+    for (unsigned i = 0; i < 12; ++i)
+        appendFloat(data, i % 4 == i / 4 + 1 ? 1.f : 0.f);
+    appendLittleEndian(data, (uint32_t)i_count);
+    for (unsigned i = 0; i < i_nbIndices; ++i)
+        appendFloat(data, indices[i]);
+    return data;
+}
+
+// Read the valid tetrahedron, in ASCII and in binary.
+static bool testValid(const char* psz_filePath) {
+    std::vector<float> vertices;
+    std::vector<uint32_t> faces;
+    std::string data = std::string(psz_asciiHeader) + "3 0 2 1\n3 0 1 3\n3 0 3 2\n3 1 2 3\n";
+    if (!readData(psz_filePath, data, vertices, faces) || vertices.size() != 12 || faces.size() != 16 ||
+        faces[13] != 1) {
+        printf("The ASCII tetrahedron is not read.\n");
+        return false;
+    }
+
+    const float indices[] = {0, 2, 1};
+    if (!readData(psz_filePath, binaryFace(3, indices, 3), vertices, faces) || vertices.size() != 12 ||
+        faces.size() != 4 || faces[2] != 2) {
+        printf("The binary tetrahedron is not read.\n");
+        return false;
+    }
+    return true;
+}
+
+// Read files with invalid list counts and vertex indices.
+static bool testInvalid(const char* psz_filePath) {
+    static const char* faceLines[] = {
+        "-1 0 2 1\n",          // Negative count.
+        "4294967299 0 2 1\n",  // Count above the uint32_t range.
+        "1e300 0 2 1\n",       // Count above the size_t range.
+        "3 0 -2 1\n",          // Negative index.
+        "3 0 4294967296 1\n",  // Index above the uint32_t range.
+        "3 0 1e20 1\n",        // Index above the uint32_t range, in exponent notation.
+    };
+
+    bool b_ok = true;
+    std::vector<float> vertices;
+    std::vector<uint32_t> faces;
+    for (unsigned i = 0; i < sizeof(faceLines) / sizeof(faceLines[0]); ++i) {
+        std::string data = std::string(psz_asciiHeader) + faceLines[i] + "3 0 1 3\n3 0 3 2\n3 1 2 3\n";
+        if (readData(psz_filePath, data, vertices, faces)) {
+            printf("The ASCII face '%.*s' is read.\n", (int)strlen(faceLines[i]) - 1, faceLines[i]);
+            b_ok = false;
+        }
+    }
+
+    const float invalidIndices[][3] = {{0, -1, 1}, {0, 5e9f, 1}, {0, NAN, 1}, {0, INFINITY, 1}};
+    for (unsigned i = 0; i < sizeof(invalidIndices) / sizeof(invalidIndices[0]); ++i) {
+        if (readData(psz_filePath, binaryFace(3, invalidIndices[i], 3), vertices, faces)) {
+            printf("The binary face %u with an invalid index is read.\n", i);
+            b_ok = false;
+        }
+    }
+
+    const float indices[] = {0, 2, 1};
+    if (readData(psz_filePath, binaryFace(-1, indices, 3), vertices, faces)) {
+        printf("The binary face with a negative count is read.\n");
+        b_ok = false;
+    }
+    return b_ok;
+}
+
+int main(int argc, char** argv) {
+    const char* psz_filePath = argc > 1 ? argv[1] : "meshReaderTest.ply";
+
+    bool b_ok = testValid(psz_filePath);
+    b_ok = testInvalid(psz_filePath) && b_ok;
+
+    remove(psz_filePath);
+    return b_ok && !b_missingError ? EXIT_SUCCESS : EXIT_FAILURE;
+}
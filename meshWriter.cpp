@@ -0,0 +1,138 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "meshWriter.h"
+
+#include <charconv>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+
+// Maximal number of characters of a float and of a face element in an OFF file.
+#define OFF_MAX_FLOAT_LENGTH 16
+#define OFF_MAX_INDEX_LENGTH 11
+
+// Test the end of a file path.
+static bool hasExtension(const char psz_filePath[], const char psz_extension[]) {
+    size_t i_pathLength = strlen(psz_filePath);
+    size_t i_extensionLength = strlen(psz_extension);
+    return i_pathLength >= i_extensionLength &&
+           strcmp(psz_filePath + i_pathLength - i_extensionLength, psz_extension) == 0;
+}
+
+// Append raw bytes to the file content.
+static inline char* appendBytes(char* p, const void* p_data, size_t i_size) {
+    memcpy(p, p_data, i_size);
+    return p + i_size;
+}
+
+// Format the mesh in the OFF format.
+static size_t formatOff(char* p_begin, const std::vector<float>& vertices, const std::vector<uint32_t>& faces,
+                        size_t i_nbFaces) {
+    char* p = p_begin + sprintf(p_begin, "OFF\n%lu %lu 0\n", vertices.size() / 3, i_nbFaces);
+
+    // The coordinates are written with 6 significant digits like the default of the C++ streams.
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        p = std::to_chars(p, p + OFF_MAX_FLOAT_LENGTH, vertices[i], std::chars_format::general, 6).ptr;
+        *p++ = i % 3 == 2 ? '\n' : ' ';
+    }
+
+    for (size_t i = 0; i < faces.size(); i += faces[i] + 1) {
+        for (unsigned j = 0; j <= faces[i]; ++j) {
+            p = std::to_chars(p, p + OFF_MAX_INDEX_LENGTH, faces[i + j]).ptr;
+            *p++ = j == faces[i] ? '\n' : ' ';
+        }
+    }
+
+    return p - p_begin;
+}
+
+// Format the mesh in the binary PLY format.
+static size_t formatPly(char* p_begin, const std::vector<float>& vertices, const std::vector<uint32_t>& faces,
+                        size_t i_nbFaces, uint32_t i_maxDegree) {
+    uint16_t i_one = 1;
+    bool b_littleEndianHost = *(unsigned char*)&i_one == 1;
+    bool b_byteDegree = i_maxDegree <= UINT8_MAX;
+
+    char* p = p_begin + sprintf(p_begin,
+                                "ply\n"
+                                "format %s 1.0\n"
+                                "element vertex %lu\n"
+                                "property float x\n"
+                                "property float y\n"
+                                "property float z\n"
+                                "element face %lu\n"
+                                "property list %s int vertex_indices\n"
+                                "end_header\n",
+                                b_littleEndianHost ? "binary_little_endian" : "binary_big_endian",
+                                vertices.size() / 3, i_nbFaces, b_byteDegree ? "uchar" : "uint");
+
+    p = appendBytes(p, vertices.data(), vertices.size() * sizeof(float));
+
+    for (size_t i = 0; i < faces.size(); i += faces[i] + 1) {
+        if (b_byteDegree)
+            *p++ = (uint8_t)faces[i];
+        else
+            p = appendBytes(p, &faces[i], sizeof(uint32_t));
+        p = appendBytes(p, &faces[i + 1], faces[i] * sizeof(uint32_t));
+    }
+
+    return p - p_begin;
+}
+
+// Format the mesh in the raw format.
+static size_t formatRaw(char* p_begin, const std::vector<float>& vertices, const std::vector<uint32_t>& faces,
+                        size_t i_nbFaces) {
+    uint32_t header[3] = {(uint32_t)(vertices.size() / 3), (uint32_t)i_nbFaces, (uint32_t)faces.size()};
+
+    char* p = appendBytes(p_begin, header, sizeof(header));
+    p = appendBytes(p, vertices.data(), vertices.size() * sizeof(float));
+    p = appendBytes(p, faces.data(), faces.size() * sizeof(uint32_t));
+
+    return p - p_begin;
+}
+
+bool writeMeshFile(const char psz_filePath[], const std::vector<float>& vertices, const std::vector<uint32_t>& faces) {
+    size_t i_nbFaces = 0;
+    uint32_t i_maxDegree = 0;
+    for (size_t i = 0; i < faces.size(); i += faces[i] + 1) {
+        i_nbFaces++;
+        if (faces[i] > i_maxDegree)
+            i_maxDegree = faces[i];
+    }
+
+    // Upper bound of the file size, headers included.
+    size_t i_maxSize = 512 + vertices.size() * OFF_MAX_FLOAT_LENGTH + faces.size() * OFF_MAX_INDEX_LENGTH;
+    std::unique_ptr<char[]> p_content(new char[i_maxSize]);
+
+    size_t i_size;
+    if (hasExtension(psz_filePath, ".ply"))
+        i_size = formatPly(p_content.get(), vertices, faces, i_nbFaces, i_maxDegree);
+    else if (hasExtension(psz_filePath, ".raw"))
+        i_size = formatRaw(p_content.get(), vertices, faces, i_nbFaces);
+    else
+        i_size = formatOff(p_content.get(), vertices, faces, i_nbFaces);
+
+    FILE* p_file = fopen(psz_filePath, "wb");
+    if (p_file == NULL)
+        return false;
+
+    bool b_ret = fwrite(p_content.get(), 1, i_size, p_file) == i_size;
+    return fclose(p_file) == 0 && b_ret;
+}
@@ -0,0 +1,39 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef MESHWRITER_H
+#define MESHWRITER_H
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Write a mesh in a file. The format is chosen from the file extension:
+ * - .ply: binary PLY;
+ * - .raw: the number of vertices, the number of faces and the size of the face
+ *   array as 32 bits integers, followed by the two arrays, in the host byte order;
+ * - any other extension: ASCII OFF.
+ * The file content is formatted in memory and written at once.
+ * \param vertices the x, y and z coordinates of each vertex.
+ * \param faces for each face, its number of vertices followed by their ids.
+ * \return false if the file can not be written.
+ */
+bool writeMeshFile(const char psz_filePath[], const std::vector<float>& vertices, const std::vector<uint32_t>& faces);
+
+#endif  // MESHWRITER_H
@@ -0,0 +1,166 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "modelPriors.h"
+
+#include "rangeCoder/staticmodel.h"
+
+#include <assert.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+// Counts of the trained priors, by id. The first one is the uniform models.
+static const ModelCounts trainedModelCounts[] = {
+    {},
+#include "modelCounts1.inc"
+};
+
+#define NB_MODEL_PRIORS (sizeof(trainedModelCounts) / sizeof(trainedModelCounts[0]))
+
+// Compute the priors of all the trained counts.
+static std::vector<ModelPriors> computeTrainedModelPriors() {
+    std::vector<ModelPriors> priors(NB_MODEL_PRIORS);
+    for (unsigned i = 1; i < NB_MODEL_PRIORS; ++i)
+        computeModelPriors(trainedModelCounts[i], priors[i]);
+    return priors;
+}
+
+const ModelPriors* getModelPriors(unsigned i_id) {
+    // Computed on the first call. The initialization of a local static is thread safe.
+    static const std::vector<ModelPriors> priors = computeTrainedModelPriors();
+
+    if (i_id == 0 || i_id >= NB_MODEL_PRIORS)
+        return NULL;
+    return &priors[i_id];
+}
+
+/**
+ * Compute the initial frequencies of a model from its symbol counts.
+ * Each symbol is counted once more, so that every symbol can be coded.
+ */
+static void computeQsModelPriors(const uint32_t* p_counts, unsigned i_nbSymbols, int i_lgTotFreq, int* p_priors) {
+    uint4 counts[RESIDUAL_NB_CLASSES], freqs[RESIDUAL_NB_CLASSES];
+    assert(i_nbSymbols <= RESIDUAL_NB_CLASSES);
+
+    for (unsigned i = 0; i < i_nbSymbols; ++i)
+        counts[i] = p_counts[i] + 1;
+    normalizefreqs(counts, i_nbSymbols, i_lgTotFreq, freqs);
+    for (unsigned i = 0; i < i_nbSymbols; ++i)
+        p_priors[i] = freqs[i];
+}
+
+// Compute the initial frequency of the 0 of a binary model from its bit counts.
+static binmodel computeBinModelPrior(const uint32_t* p_counts) {
+    const unsigned i_minFreq = (1 << BINMODEL_ADAPT_SHIFT) - 1;
+    const unsigned i_maxFreq = (1 << BINMODEL_LG_TOTF) - (1 << BINMODEL_ADAPT_SHIFT) + 1;
+
+    uint64_t i_total = (uint64_t)p_counts[0] + p_counts[1] + 2;
+    unsigned i_freq = ((p_counts[0] + 1) << BINMODEL_LG_TOTF) / i_total;
+    return std::min(std::max(i_freq, i_minFreq), i_maxFreq);
+}
+
+void computeModelPriors(const ModelCounts& counts, ModelPriors& priors) {
+    computeQsModelPriors(counts.alphaBeta, RESIDUAL_NB_CLASSES, 18, priors.alphaBeta);
+    computeQsModelPriors(counts.gamma, RESIDUAL_NB_CLASSES, 18, priors.gamma);
+    computeQsModelPriors(counts.quant, QUANT_MODEL_NB_SYMBOLS, 12, priors.quant);
+    for (unsigned i = 0; i < NB_FACE_CONNECT_CONTEXTS; ++i)
+        priors.faceConnect[i] = computeBinModelPrior(counts.faceConnect[i]);
+    for (unsigned i = 0; i < NB_EDGE_CONNECT_CONTEXTS; ++i)
+        priors.edgeConnect[i] = computeBinModelPrior(counts.edgeConnect[i]);
+}
+
+void resetBinModels(binmodel* p_models, unsigned i_nbModels, const binmodel* p_priors) {
+    for (unsigned i = 0; i < i_nbModels; ++i) {
+        if (p_priors != NULL)
+            p_models[i] = p_priors[i];
+        else
+            initbinmodel(&p_models[i]);
+    }
+}
+
+/**
+ * Read the model counts written by writeModelCounts().
+ * The comment lines are skipped and the counts are read in the order of the structure fields.
+ * \return false if the file can not be read or does not have the right number of counts.
+ */
+bool readModelCounts(const char* psz_filePath, ModelCounts& counts) {
+    FILE* p_file = fopen(psz_filePath, "r");
+    if (p_file == NULL)
+        return false;
+
+    uint32_t* p_counts = (uint32_t*)&counts;
+    const unsigned i_nbCounts = sizeof(ModelCounts) / sizeof(uint32_t);
+    unsigned i_nbRead = 0;
+
+    char line[4096];
+    while (fgets(line, sizeof(line), p_file) != NULL) {
+        // The comment lines are indented like the counts.
+        char* p = line;
+        while (isspace((unsigned char)*p))
+            p++;
+        if (!strncmp(p, "//", 2))
+            continue;
+        while (*p != '\0') {
+            if (!isdigit((unsigned char)*p)) {
+                p++;
+                continue;
+            }
+            unsigned long i_count = strtoul(p, &p, 10);
+            if (i_nbRead < i_nbCounts)
+                p_counts[i_nbRead] = i_count;
+            i_nbRead++;
+        }
+    }
+
+    fclose(p_file);
+    return i_nbRead == i_nbCounts;
+}
+
+// Write a list of counts as an initializer.
+static void writeCounts(FILE* p_file, const char* psz_name, const uint32_t* p_counts, unsigned i_nbCounts) {
+    fprintf(p_file, "    // %s\n    {", psz_name);
+    for (unsigned i = 0; i < i_nbCounts; ++i)
+        fprintf(p_file, "%s%u", i == 0 ? "" : i % 12 == 0 ? ",\n     " : ", ", p_counts[i]);
+    fprintf(p_file, "},\n");
+}
+
+/**
+ * Write the model counts as an initializer of the ModelCounts structure, to be compiled in the codec.
+ * \return false if the file can not be written.
+ */
+bool writeModelCounts(const char* psz_filePath, const ModelCounts& counts) {
+    FILE* p_file = fopen(psz_filePath, "w");
+    if (p_file == NULL)
+        return false;
+
+    fprintf(p_file, "// Model symbol counts written by ppmc --train-priors.\n{\n");
+    writeCounts(p_file, "alpha and beta residual classes", counts.alphaBeta, RESIDUAL_NB_CLASSES);
+    writeCounts(p_file, "gamma residual classes", counts.gamma, RESIDUAL_NB_CLASSES);
+    writeCounts(p_file, "adaptive quantization", counts.quant, QUANT_MODEL_NB_SYMBOLS);
+    writeCounts(p_file, "face connectivity contexts", &counts.faceConnect[0][0], 2 * NB_FACE_CONNECT_CONTEXTS);
+    writeCounts(p_file, "edge connectivity contexts", &counts.edgeConnect[0][0], 2 * NB_EDGE_CONNECT_CONTEXTS);
+    fprintf(p_file, "},\n");
+
+    return fclose(p_file) == 0;
+}
@@ -0,0 +1,68 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef MODELPRIORS_H
+#define MODELPRIORS_H
+
+/*
+  Priors of the entropy coding models.
+
+  Without priors, the models of each level of detail start uniform and the
+  small levels spend much of their size adapting. The priors are computed
+  from the symbol counts of a corpus of meshes, gathered with the
+  --train-priors option of the compressor, and compiled in the codec. The
+  compressed files reference them by id.
+*/
+
+#include "configuration.h"
+
+#include "rangeCoder/binmodel.h"
+
+#include <stdint.h>
+
+// Symbol counts of the models, accumulated over the levels of detail of a corpus.
+struct ModelCounts {
+    uint32_t alphaBeta[RESIDUAL_NB_CLASSES];
+    uint32_t gamma[RESIDUAL_NB_CLASSES];
+    uint32_t quant[QUANT_MODEL_NB_SYMBOLS];
+    uint32_t faceConnect[NB_FACE_CONNECT_CONTEXTS][2];
+    uint32_t edgeConnect[NB_EDGE_CONNECT_CONTEXTS][2];
+};
+
+// Initial frequencies of the models.
+struct ModelPriors {
+    int alphaBeta[RESIDUAL_NB_CLASSES];  // Summing to 1 << 18.
+    int gamma[RESIDUAL_NB_CLASSES];      // Summing to 1 << 18.
+    int quant[QUANT_MODEL_NB_SYMBOLS];   // Summing to 1 << 12.
+    binmodel faceConnect[NB_FACE_CONNECT_CONTEXTS];
+    binmodel edgeConnect[NB_EDGE_CONNECT_CONTEXTS];
+};
+
+// Priors of an id, NULL if the id is unknown. The id 0 is the uniform models.
+const ModelPriors* getModelPriors(unsigned i_id);
+
+void computeModelPriors(const ModelCounts& counts, ModelPriors& priors);
+
+// Reset binary models to their priors, or to equiprobable bits if p_priors is NULL.
+void resetBinModels(binmodel* p_models, unsigned i_nbModels, const binmodel* p_priors);
+
+bool readModelCounts(const char* psz_filePath, ModelCounts& counts);
+bool writeModelCounts(const char* psz_filePath, const ModelCounts& counts);
+
+#endif  // MODELPRIORS_H
@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+/*
+  Model counts file test.
+
+  Writes model counts with writeModelCounts() and reads them back with
+  readModelCounts(), then reads a file whose indented comment lines
+  contain numbers, which must not be taken for counts.
+
+  Usage: modelpriorstest [temporary file path]
+*/
+
+#include "modelPriors.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Fill the counts with values of various lengths.
+static void fillCounts(ModelCounts& counts) {
+    uint32_t* p_counts = (uint32_t*)&counts;
+    for (unsigned i = 0; i < sizeof(ModelCounts) / sizeof(uint32_t); ++i)
+        p_counts[i] = i * 2654435761u >> (i % 32);
+}
+
+// Write and read back the counts.
+static bool testRoundTrip(const char* psz_filePath) {
+    ModelCounts counts, readCounts;
+    fillCounts(counts);
+    memset(&readCounts, 0, sizeof(readCounts));
+
+    if (!writeModelCounts(psz_filePath, counts) || !readModelCounts(psz_filePath, readCounts)) {
+        printf("The counts can not be written and read back.\n");
+        return false;
+    }
+    if (memcmp(&counts, &readCounts, sizeof(ModelCounts)) != 0) {
+        printf("The counts read back differ from the written ones.\n");
+        return false;
+    }
+    return true;
+}
+
+// Read counts preceded by indented comment lines that contain numbers.
+static bool testIndentedComments(const char* psz_filePath) {
+    ModelCounts counts, readCounts;
+    fillCounts(counts);
+    memset(&readCounts, 0, sizeof(readCounts));
+
+    FILE* p_file = fopen(psz_filePath, "w");
+    if (p_file == NULL) {
+        printf("Can't write the file %s.\n", psz_filePath);
+        return false;
+    }
+    const uint32_t* p_counts = (const uint32_t*)&counts;
+    fprintf(p_file, "// 1 header comment\n{\n");
+    for (unsigned i = 0; i < sizeof(ModelCounts) / sizeof(uint32_t); ++i)
+        fprintf(p_file, "  \t// count %u of 2\n    %u,\n", i, p_counts[i]);
+    fprintf(p_file, "},\n");
+    fclose(p_file);
+
+    if (!readModelCounts(psz_filePath, readCounts) || memcmp(&counts, &readCounts, sizeof(ModelCounts)) != 0) {
+        printf("The numbers of indented comment lines are read as counts.\n");
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* psz_filePath = argc > 1 ? argv[1] : "modelCountsTest.txt";
+
+    bool b_ok = testRoundTrip(psz_filePath);
+    b_ok = testIndentedComments(psz_filePath) && b_ok;
+
+    remove(psz_filePath);
+    return b_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -20,8 +20,11 @@
 #include "mymesh.h"
 #include "configuration.h"
 #include "frenetRotation.h"
+#include "meshReader.h"
 
 #include <algorithm>
+#include <stdarg.h>
+#include <stdio.h>
 
 MyMesh::MyMesh(char filename[],
                std::string filePathOutput,
@@ -34,103 +37,240 @@ MyMesh::MyMesh(char filename[],
                bool b_useConnectivityPredictionFaces,
                bool b_useConnectivityPredictionEdges,
                bool b_allowConcaveFaces,
-               bool b_useTriangleMeshConnectivityPredictionFaces)
-    : CGAL::Polyhedron_3<CGAL::Simple_cartesian<float>, MyItems>(), i_mode(i_mode), b_jobCompleted(false),
-      operation(Idle), i_curDecimationId(0), i_curQuantizationId(0), i_curOperationId(0), i_levelNotConvexId(0),
-      b_testConvexity(false), connectivitySize(0), geometrySize(0), i_quantBits(i_quantBits), dataOffset(0),
-      filePathOutput(filePathOutput), i_decompPercentage(i_decompPercentage), osDebug(&fbDebug),
+               bool b_useTriangleMeshConnectivityPredictionFaces,
+               bool b_useRans,
+               bool b_useStaticTables,
+               unsigned i_modelPriorsId,
+               bool b_useWarmStart,
+               bool b_verbose)
+    : HalfedgeMesh<MyItems>(), i_mode(i_mode), b_jobCompleted(false), b_error(false), b_verbose(b_verbose),
+      b_streaming(false), operation(Idle), i_curDecimationId(0), i_curQuantizationId(0), i_curOperationId(0),
+      i_levelNotConvexId(0), b_testConvexity(!b_allowConcaveFaces), connectivitySize(0), geometrySize(0),
+      i_quantBits(i_quantBits), filePathOutput(filePathOutput), i_decompPercentage(i_decompPercentage),
       b_useAdaptiveQuantization(b_useAdaptiveQuantization), b_useLiftingScheme(b_useLiftingScheme),
       b_useCurvaturePrediction(b_useCurvaturePrediction),
       b_useConnectivityPredictionFaces(b_useConnectivityPredictionFaces),
       b_useConnectivityPredictionEdges(b_useConnectivityPredictionEdges),
-      b_useTriangleMeshConnectivityPredictionFaces(b_useTriangleMeshConnectivityPredictionFaces) {
-    // Create the compressed data buffer.
-    p_data = new char[BUFFER_SIZE];
-    // Fill the buffer with 0.
-    for (size_t i = 0; i < BUFFER_SIZE; ++i)
-        p_data[i] = 0;
+      b_useTriangleMeshConnectivityPredictionFaces(b_useTriangleMeshConnectivityPredictionFaces), b_useRans(b_useRans),
+      b_useStaticTables(b_useStaticTables), b_useWarmStart(b_useWarmStart), i_modelPriorsId(i_modelPriorsId), p_modelPriors(NULL), p_modelCounts(NULL) {
+    // Create the compressed data buffer. It is allocated on the first write.
+    initdatabuffer(&dataBuffer);
+
+    // Initialise the entropy coder structures.
+    rangeCoder.p_buffer = &dataBuffer;
+    initranscoder(&ransCoder, &dataBuffer);
+
+    // The priors of a compressed file are set when its header is read.
+    if (i_mode == COMPRESSION_MODE_ID) {
+        p_modelPriors = getModelPriors(i_modelPriorsId);
+        if (i_modelPriorsId != 0 && p_modelPriors == NULL) {
+            stopOnError("Unknown model priors id: %u.", i_modelPriorsId);
+        }
+    }
 
-    // Initialise the range coder structure.
-    rangeCoder.p_data = p_data;
-    rangeCoder.p_dataOffset = &dataOffset;
+    // Allocate the models once, so that the levels of detail are coded without allocations.
+    int b_compress = i_mode == COMPRESSION_MODE_ID;
+    for (unsigned i = 0; i < NB_RESIDUAL_CONTEXTS; ++i) {
+        initqsmodel(&alphaBetaModels[i], RESIDUAL_NB_CLASSES, 18, 1 << 17, NULL, b_compress);
+#ifdef USE_BIJECTION
+        initqsmodel(&gammaModels[i], RESIDUAL_NB_CLASSES, 18, 1 << 17, NULL, b_compress);
+#endif
+    }
+    initstaticmodel(&alphaBetaTable, RESIDUAL_NB_CLASSES, STATIC_MODEL_LG_TOTF, b_compress);
+#ifdef USE_BIJECTION
+    initstaticmodel(&gammaTable, RESIDUAL_NB_CLASSES, STATIC_MODEL_LG_TOTF, b_compress);
+#endif
+    initqsmodel(&quantModel, QUANT_MODEL_NB_SYMBOLS, 12, 2000, NULL, b_compress);
+    initqsmodel(&costModel, RESIDUAL_NB_CLASSES, 18, 1 << 17, NULL, 1);
 
     if (i_mode == COMPRESSION_MODE_ID)  // Compression mode.
     {
-        std::filebuf fb;
-        fb.open(filename, std::ios::in);
-        if (fb.is_open()) {
-            std::istream is(&fb);
-            is >> *this;
-
-            fb.close();
-
-            if (keep_largest_connected_components(1) != 0) {
-                std::cout << "Can't compress the mesh." << std::endl;
-                std::cout << "The codec doesn't handle meshes with several connected components." << std::endl;
-                exit(EXIT_FAILURE);
+        // Without a file, the mesh is given by the caller with loadMesh().
+        if (filename != NULL) {
+            std::vector<float> vertices;
+            std::vector<uint32_t> faces;
+            std::string error;
+            if (!readMeshFile(filename, vertices, faces, error))
+                stopOnError("%s", error.c_str());
+            else
+                loadMesh(vertices, faces);
+        }
+    }
+    else  // Decompression mode.
+    {
+        // The extension of the output path sets the format of the decompressed meshes.
+        outputMeshExtension = ".off";
+        size_t i_dotPos = this->filePathOutput.rfind('.');
+        if (i_dotPos != std::string::npos) {
+            std::string extension = this->filePathOutput.substr(i_dotPos);
+            if (extension == ".off" || extension == ".ply" || extension == ".raw") {
+                outputMeshExtension = extension;
+                this->filePathOutput.erase(i_dotPos);
             }
+        }
 
-            if (!is_closed()) {
-                std::cout << "Can't compress the mesh." << std::endl;
-                std::cout << "The codec doesn't handle meshes with borders." << std::endl;
-                exit(EXIT_FAILURE);
-            }
+        /* Without a file, the compressed data is pushed by the caller
+           and the decompression begins once the base mesh has arrived. */
+        if (filename == NULL)
+            b_streaming = true;
+        else {
+            if (readCompressedFile(filename) != 0)
+                stopOnError("Can't read the compressed file '%s'.", filename);
+            else
+                beginDecompression();
+        }
+    }
+
+    i_nbVerticesInit = size_of_vertices();
+    i_nbFacetsInit = size_of_facets();
+    printProgress("Number of vertices: %lu.\nNumber of faces: %lu.\n", i_nbVerticesInit, i_nbFacetsInit);
+}
+
+MyMesh::~MyMesh() {
+    for (unsigned i = 0; i < NB_RESIDUAL_CONTEXTS; ++i) {
+        deleteqsmodel(&alphaBetaModels[i]);
+#ifdef USE_BIJECTION
+        deleteqsmodel(&gammaModels[i]);
+#endif
+    }
+    deletestaticmodel(&alphaBetaTable);
+#ifdef USE_BIJECTION
+    deletestaticmodel(&gammaTable);
+#endif
+    deleteqsmodel(&quantModel);
+    deleteqsmodel(&costModel);
+    delete p_modelCounts;
+    deleteranscoder(&ransCoder);
+    deletedatabuffer(&dataBuffer);
+}
+
+/**
+ * Gather the symbol counts of the models during the compression and add them
+ * to the counts of a file, to train the model priors from a corpus of meshes.
+ */
+void MyMesh::trainModelPriors(const char* psz_countsFilePath) {
+    p_modelCounts = new ModelCounts();
+    modelCountsFilePath = psz_countsFilePath;
+}
+
+/**
+ * Record the symbols given to the models during the compression in a file,
+ * to benchmark the entropy coders on them.
+ */
+void MyMesh::recordSymbolStreams(const char* psz_filePath) {
+    symbolStreamsFilePath = psz_filePath;
+}
 
-            /* The special connectivity prediction scheme for triangle
-               mesh is not used if the current mesh is not a pure triangle mesh. */
-            if (!is_pure_triangle())
-                this->b_useTriangleMeshConnectivityPredictionFaces = false;
+/**
+ * Check the mesh to compress and quantize its vertex positions.
+ * \return false if the codec can not handle the mesh, in which case the job is stopped.
+ */
+bool MyMesh::beginCompression() {
+    if (keep_largest_connected_components(1) != 0) {
+        stopOnError("Can't compress the mesh. The codec doesn't handle meshes with several connected components.");
+        return false;
+    }
 
-            computeBoundingBox();
-            determineQuantStep();
-            quantizeVertexPositions();
+    if (!is_closed()) {
+        stopOnError("Can't compress the mesh. The codec doesn't handle meshes with borders.");
+        return false;
+    }
+
+    if (!is_manifold()) {
+        stopOnError("Can't compress the mesh. The codec doesn't handle non-manifold meshes.");
+        return false;
+    }
+
+    /* The special connectivity prediction scheme for triangle
+       mesh is not used if the current mesh is not a pure triangle mesh. */
+    if (!is_pure_triangle())
+        this->b_useTriangleMeshConnectivityPredictionFaces = false;
+
+    computeBoundingBox();
+    determineQuantStep();
+    quantizeVertexPositions();
 
 #if 0
-            // Output the initial quantified mesh in an off file.
-            writeMeshOff("mesh_quant.off");
+    // Output the initial quantified mesh in an off file.
+    writeMesh("mesh_quant.off");
 #endif
 
-            printf("Bounding box min coordinates: %f %f %f.\n", bbMin.x(), bbMin.y(), bbMin.z());
-            printf("Quantization step: %f\n", f_quantStep);
+    printProgress("Bounding box min coordinates: %f %f %f.\n", bbMin.x(), bbMin.y(), bbMin.z());
+    printProgress("Quantization step: %f\n", f_quantStep);
 
-            // Set the vertices of the edge that is the departure of the coding and decoding conquests.
-            vh_departureConquest[0] = halfedges_begin()->opposite()->vertex();
-            vh_departureConquest[1] = halfedges_begin()->vertex();
+    // Set the vertices of the edge that is the departure of the coding and decoding conquests.
+    vh_departureConquest[0] = halfedges_begin()->opposite()->vertex();
+    vh_departureConquest[1] = halfedges_begin()->vertex();
 
-            if (!b_allowConcaveFaces)
-                b_testConvexity = true;
-        }
-    }
-    else  // Decompression mode.
-    {
-        readCompressedFile(filename);
-        readCompressedData();
+    return true;
+}
 
-        if (i_mode == DECOMPRESSION_MODE_WRITE_ALL_ID)
-            writeCurrentOperationMesh(filePathOutput, 0);
+/**
+ * Build the mesh to compress from vertex and face arrays.
+ * \param vertices the x, y and z coordinates of each vertex.
+ * \param faces for each face, its number of vertices followed by their ids.
+ * \return false if the arrays do not describe a mesh the codec can handle, in which case the job is stopped.
+ */
+bool MyMesh::loadMesh(const std::vector<float>& vertices, const std::vector<uint32_t>& faces) {
+    assert(i_mode == COMPRESSION_MODE_ID && size_of_vertices() == 0);
 
-        // Set the vertices of the edge that is the departure of the coding and decoding conquests.
-        vh_departureConquest[0] = vertices_begin();
-        vh_departureConquest[1] = ++vertices_begin();
+    size_t i_nbVertices = vertices.size() / 3;
+    size_t i_nbFaces = 0;
 
-        if (i_levelNotConvexId - i_nbDecimations > 0) {
-            // Decompress until the first convex LOD is reached.
-            while (i_curDecimationId < i_levelNotConvexId)
-                batchOperation();
-            batchOperation();
+    for (size_t i = 0; i < faces.size(); i += faces[i] + 1) {
+        if (faces[i] < 3 || i + faces[i] >= faces.size()) {
+            stopOnError("Wrong face description at index %lu.", i);
+            return false;
+        }
+        for (unsigned j = 1; j <= faces[i]; ++j) {
+            if (faces[i + j] >= i_nbVertices) {
+                stopOnError("Wrong vertex id at index %lu.", i + j);
+                return false;
+            }
         }
+        i_nbFaces++;
+    }
+
+    if (!build(vertices, faces) || size_of_vertices() == 0) {
+        stopOnError("The arrays do not describe a valid mesh.");
+        return false;
     }
 
+    if (!beginCompression())
+        return false;
+
     i_nbVerticesInit = size_of_vertices();
     i_nbFacetsInit = size_of_facets();
-    printf("Number of vertices: %lu.\nNumber of faces: %lu.\n", i_nbVerticesInit, i_nbFacetsInit);
 
-    fbDebug.open("debug.txt", std::ios::out | std::ios::trunc);
+    return true;
 }
 
-MyMesh::~MyMesh() {
-    delete[] p_data;
-    fbDebug.close();
+/**
+ * Stop the job because the input data is invalid.
+ * \param psz_format the printf format of the error message, which is kept for getErrorMessage().
+ */
+void MyMesh::stopOnError(const char* psz_format, ...) {
+    operation = Idle;
+    b_jobCompleted = true;
+    b_error = true;
+
+    char psz_message[256];
+    va_list args;
+    va_start(args, psz_format);
+    vsnprintf(psz_message, sizeof(psz_message), psz_format, args);
+    va_end(args);
+    errorMessage = psz_message;
+}
+
+// Print a progress message on the standard output, if the mesh is verbose.
+void MyMesh::printProgress(const char* psz_format, ...) const {
+    if (!b_verbose)
+        return;
+
+    va_list args;
+    va_start(args, psz_format);
+    vprintf(psz_format, args);
+    va_end(args);
 }
 
 /**
@@ -212,7 +352,7 @@ void MyMesh::completeOperation() {
 
 // Compute the mesh vertex bounding box.
 void MyMesh::computeBoundingBox() {
-    printf("Compute the mesh bounding box.\n");
+    printProgress("Compute the mesh bounding box.\n");
     std::list<Point> vList;
     for (MyMesh::Vertex_iterator vit = vertices_begin(); vit != vertices_end(); ++vit)
         vList.push_back(vit->point());
@@ -241,7 +381,7 @@ Vector MyMesh::getBBoxCenter() const {
  * Determine the quantization step.
  */
 void MyMesh::determineQuantStep() {
-    printf("Determine the quantization step.\n");
+    printProgress("Determine the quantization step.\n");
 
     float f_maxRange = 0;
     for (unsigned i = 0; i < 3; ++i) {
@@ -260,7 +400,7 @@ void MyMesh::determineQuantStep() {
 
 // Compute and store the quantized positions of the mesh vertices.
 void MyMesh::quantizeVertexPositions() {
-    printf("Quantize the vertex positions.\n");
+    printProgress("Quantize the vertex positions.\n");
     unsigned i_maxCoord = 1 << i_quantBits;
 
     // Update the positions to fit the quantization.
@@ -24,19 +24,25 @@
 #include <iostream>
 #include <stdint.h>
 
-#include <CGAL/Polyhedron_3.h>
 #include <CGAL/Simple_cartesian.h>
 #include <CGAL/bounding_box.h>
-#include <CGAL/circulator.h>
-
-#include <CGAL/IO/Polyhedron_iostream.h>
-//#include <CGAL/IO/Polyhedron_VRML_1_ostream.h>
 
+#include <deque>
+#include <map>
 #include <queue>
+#include <vector>
+
+#include "configuration.h"
+#include "halfedgeMesh.h"
+#include "modelPriors.h"
 
 // Range coder includes.
+#include "rangeCoder/binmodel.h"
+#include "rangeCoder/databuffer.h"
 #include "rangeCoder/qsmodel.h"
 #include "rangeCoder/rangecod.h"
+#include "rangeCoder/rans.h"
+#include "rangeCoder/staticmodel.h"
 
 typedef CGAL::Simple_cartesian<float> MyKernel;
 typedef MyKernel::Point_3 Point;
@@ -49,222 +55,245 @@ typedef CGAL::Simple_cartesian<int> MyKernelInt;
 typedef MyKernelInt::Point_3 PointInt;
 typedef MyKernelInt::Vector_3 VectorInt;
 
-// My face type has a vertex flag
-template <class Refs> class MyFace : public CGAL::HalfedgeDS_face_base<Refs> {
-    enum Flag { Unknown = 0, Splittable = 1, Unsplittable = 2 };
-    enum ProcessedFlag { NotProcessed, Processed };
+// Generations of the element flags, shared by all the elements of the mesh.
+// A flag is only set if it was written during the current generation of its
+// kind, so starting a new generation resets it on all the elements at once.
+// The generations are on one byte to keep the element arrays small: the
+// elements are only swept when a counter wraps around.
+struct MyMeshData {
+    MyMeshData()
+        : i_vertexGeneration(1), i_halfedgeGeneration(1), i_faceGeneration(1), i_faceProcessedGeneration(1) {}
+
+    uint8_t i_vertexGeneration;
+    uint8_t i_halfedgeGeneration;
+    uint8_t i_faceGeneration;
+    uint8_t i_faceProcessedGeneration;
+};
 
-  public:
-    MyFace() : flag(Unknown), processedFlag(NotProcessed) {}
+// Flags of a face, stored in the face array of the mesh.
+struct MyFaceData {
+    enum Flag { Splittable = 1, Unsplittable = 2 };
 
-    inline void resetState() {
-        flag = Unknown;
-        processedFlag = NotProcessed;
-    }
+    MyFaceData() : i_generation(0), i_processedGeneration(0), flags(0) {}
 
-    inline void resetProcessedFlag() {
-        processedFlag = NotProcessed;
-    }
+    uint8_t i_generation;           // Generation in which the flags were written.
+    uint8_t i_processedGeneration;  // Generation in which the face was processed.
+    uint8_t flags;
+};
 
+// My face type has a vertex flag
+template <class Handle> class MyFace {
+    typedef MyFaceData Data;
+
+  public:
     inline bool isConquered() const {
-        return (flag == Splittable || flag == Unsplittable);
+        return (flags() & (Data::Splittable | Data::Unsplittable)) != 0;
     }
 
     inline bool isSplittable() const {
-        return (flag == Splittable);
+        return (flags() & Data::Splittable) != 0;
     }
 
     inline bool isUnsplittable() const {
-        return (flag == Unsplittable);
+        return (flags() & Data::Unsplittable) != 0;
     }
 
-    inline void setSplittable() {
-        assert(flag == Unknown);
-        flag = Splittable;
+    inline void setSplittable() const {
+        assert(!isConquered());
+        setFlags(Data::Splittable);
     }
 
-    inline void setUnsplittable() {
-        assert(flag == Unknown);
-        flag = Unsplittable;
+    inline void setUnsplittable() const {
+        assert(!isConquered());
+        setFlags(Data::Unsplittable);
     }
 
-    inline void setProcessedFlag() {
-        processedFlag = Processed;
+    inline void setProcessedFlag() const {
+        data().i_processedGeneration = meshData().i_faceProcessedGeneration;
     }
 
     inline bool isProcessed() const {
-        return (processedFlag == Processed);
+        return data().i_processedGeneration == meshData().i_faceProcessedGeneration;
     }
 
-    inline Point getRemovedVertexPos() const {
-        return removedVertexPos;
+  private:
+    inline Data& data() const {
+        return static_cast<const Handle*>(this)->data();
     }
 
-    inline void setRemovedVertexPos(Point p) {
-        removedVertexPos = p;
+    inline MyMeshData& meshData() const {
+        return static_cast<const Handle*>(this)->mesh_data();
     }
 
-    inline VectorInt getResidual() const {
-        return residual;
+    inline unsigned flags() const {
+        return data().i_generation == meshData().i_faceGeneration ? data().flags : 0;
     }
 
-    inline void setResidual(VectorInt v) {
-        residual = v;
+    inline void setFlags(unsigned i_flags) const {
+        data().i_generation = meshData().i_faceGeneration;
+        data().flags = i_flags;
     }
+};
 
-  private:
-    Flag flag;
-    ProcessedFlag processedFlag;
+// Flags of a vertex, stored in the vertex array of the mesh.
+struct MyVertexData {
+    MyVertexData() : i_conqueredGeneration(0) {}
 
-    Point removedVertexPos;
-    VectorInt residual;
+    uint8_t i_conqueredGeneration;  // Generation in which the vertex was conquered.
 };
 
 // My vertex type has a isConquered flag
-template <class Refs> class MyVertex : public CGAL::HalfedgeDS_vertex_base<Refs, CGAL::Tag_true, Point> {
-    enum Flag { Unconquered = 0, Conquered = 1 };
+template <class Handle> class MyVertex {
+    typedef MyVertexData Data;
 
   public:
-    MyVertex() : CGAL::HalfedgeDS_vertex_base<Refs, CGAL::Tag_true, Point>(), flag(Unconquered) {}
-
-    MyVertex(const Point& p) : CGAL::HalfedgeDS_vertex_base<Refs, CGAL::Tag_true, Point>(p), flag(Unconquered) {}
-
-    inline void resetState() {
-        flag = Unconquered;
-    }
-
     inline bool isConquered() const {
-        return flag == Conquered;
-    }
-
-    inline void setConquered() {
-        flag = Conquered;
-    }
-
-    inline size_t getId() const {
-        return id;
-    }
-
-    inline void setId(size_t nId) {
-        id = nId;
+        return data().i_conqueredGeneration == meshData().i_vertexGeneration;
     }
 
-    inline unsigned getQuantCellId() const {
-        return i_quantCellId;
+    inline void setConquered() const {
+        data().i_conqueredGeneration = meshData().i_vertexGeneration;
     }
 
-    inline void setQuantCellId(unsigned nId) {
-        i_quantCellId = nId;
-    }
-
-    inline Point getOldPos() const {
-        return oldPos;
+  private:
+    inline Data& data() const {
+        return static_cast<const Handle*>(this)->data();
     }
 
-    inline void setOldPos(Point pos) {
-        oldPos = pos;
+    inline MyMeshData& meshData() const {
+        return static_cast<const Handle*>(this)->mesh_data();
     }
+};
 
-  private:
-    Flag flag;
-    size_t id;
-    unsigned i_quantCellId;
-    Point oldPos;
+// Flags of a halfedge, stored in the halfedge array of the mesh.
+struct MyHalfedgeData {
+    // Queue state on the two low bits, then the original, added or new state and the processed flag.
+    enum Flag {
+        InQueue = 1,
+        InQueue2 = 2,
+        NoLongerInQueue = 3,
+        QueueMask = 3,
+        Added = 4,
+        New = 8,
+        OriginMask = 12,
+        Processed = 16
+    };
+
+    MyHalfedgeData() : i_generation(0), flags(0) {}
+
+    uint8_t i_generation;  // Generation in which the flags were written.
+    uint8_t flags;
 };
 
 // My vertex type has a isConquered flag
-template <class Refs> class MyHalfedge : public CGAL::HalfedgeDS_halfedge_base<Refs> {
-    enum Flag { NotYetInQueue = 0, InQueue = 1, InQueue2 = 2, NoLongerInQueue = 3 };
-    enum Flag2 { Original, Added, New };
-    enum ProcessedFlag { NotProcessed, Processed };
+template <class Handle> class MyHalfedge {
+    typedef MyHalfedgeData Data;
 
   public:
-    MyHalfedge() : flag(NotYetInQueue), flag2(Original), processedFlag(NotProcessed) {}
-
-    inline void resetState() {
-        flag = NotYetInQueue;
-        flag2 = Original;
-        processedFlag = NotProcessed;
-    }
-
     /* Flag 1 */
 
-    inline void setInQueue() {
-        flag = InQueue;
+    inline void setInQueue() const {
+        setQueueState(Data::InQueue);
     }
 
-    inline void setInProblematicQueue() {
-        assert(flag == InQueue);
-        flag = InQueue2;
+    inline void setInProblematicQueue() const {
+        assert(isInNormalQueue());
+        setQueueState(Data::InQueue2);
     }
 
-    inline void removeFromQueue() {
-        assert(flag == InQueue || flag == InQueue2);
-        flag = NoLongerInQueue;
+    inline void removeFromQueue() const {
+        assert(isInNormalQueue() || isInProblematicQueue());
+        setQueueState(Data::NoLongerInQueue);
     }
 
     inline bool isInNormalQueue() const {
-        return flag == InQueue;
+        return (flags() & Data::QueueMask) == Data::InQueue;
     }
 
     inline bool isInProblematicQueue() const {
-        return flag == InQueue2;
+        return (flags() & Data::QueueMask) == Data::InQueue2;
     }
 
     /* Processed flag */
 
-    inline void resetProcessedFlag() {
-        processedFlag = NotProcessed;
-    }
-
-    inline void setProcessed() {
-        processedFlag = Processed;
+    inline void setProcessed() const {
+        setFlags(flags() | Data::Processed);
     }
 
     inline bool isProcessed() const {
-        return (processedFlag == Processed);
+        return (flags() & Data::Processed) != 0;
     }
 
     /* Flag 2 */
 
-    inline void setAdded() {
-        assert(flag2 == Original);
-        flag2 = Added;
+    inline void setAdded() const {
+        assert(isOriginal());
+        setFlags(flags() | Data::Added);
     }
 
-    inline void setNew() {
-        assert(flag2 == Original);
-        flag2 = New;
+    inline void setNew() const {
+        assert(isOriginal());
+        setFlags(flags() | Data::New);
     }
 
     inline bool isAdded() const {
-        return flag2 == Added;
+        return (flags() & Data::OriginMask) == Data::Added;
     }
 
     inline bool isOriginal() const {
-        return flag2 == Original;
+        return (flags() & Data::OriginMask) == 0;
     }
 
     inline bool isNew() const {
-        return flag2 == New;
+        return (flags() & Data::OriginMask) == Data::New;
     }
 
   private:
-    Flag flag;
-    Flag2 flag2;
-    ProcessedFlag processedFlag;
+    inline Data& data() const {
+        return static_cast<const Handle*>(this)->data();
+    }
+
+    inline MyMeshData& meshData() const {
+        return static_cast<const Handle*>(this)->mesh_data();
+    }
+
+    inline unsigned flags() const {
+        return data().i_generation == meshData().i_halfedgeGeneration ? data().flags : 0;
+    }
+
+    inline void setFlags(unsigned i_flags) const {
+        data().i_generation = meshData().i_halfedgeGeneration;
+        data().flags = i_flags;
+    }
+
+    inline void setQueueState(unsigned i_state) const {
+        setFlags((flags() & ~Data::QueueMask) | i_state);
+    }
 };
 
-struct MyItems : public CGAL::Polyhedron_items_3
-{
-    template <class Refs, class Traits> struct Face_wrapper
-    { typedef MyFace<Refs> Face; };
+// Items of the mesh: the element flags, their generations and the handle mixins that access them.
+struct MyItems {
+    typedef Point Point_3;
 
-    template <class Refs, class Traits> struct Vertex_wrapper
-    { typedef MyVertex<Refs> Vertex; };
+    typedef MyVertexData Vertex_data;
+    typedef MyHalfedgeData Halfedge_data;
+    typedef MyFaceData Face_data;
+    typedef MyMeshData Mesh_data;
 
-    template <class Refs, class Traits> struct Halfedge_wrapper
-    { typedef MyHalfedge<Refs> Halfedge; };
+    template <class Handle> using Vertex = MyVertex<Handle>;
+    template <class Handle> using Halfedge = MyHalfedge<Handle>;
+    template <class Handle> using Face = MyFace<Handle>;
+};
+
+// Entry of the level of detail index written at the beginning of the compressed file.
+struct LodIndexEntry {
+    uint64_t i_offset;            // Offset of the LOD data from the beginning of the file.
+    uint64_t i_size;              // Size of the LOD data in bytes.
+    uint32_t i_nbVertices;        // Number of vertices once the LOD is decoded.
+    uint32_t i_nbFaces;           // Number of faces once the LOD is decoded.
+    uint8_t i_operationType;      // Operation of the LOD: base mesh, decimation or adaptive quantization.
+    uint64_t i_connectivitySize;  // Size of the LOD connectivity in bits.
+    uint64_t i_geometrySize;      // Size of the LOD geometry in bits.
 };
 
 // Operation list.
@@ -279,8 +308,7 @@ enum Operation {
     AdaptiveUnquantization  // Decompression.
 };
 
-class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
-    typedef CGAL::Polyhedron_3<MyKernel, MyItems> PolyhedronT;
+class MyMesh : public HalfedgeMesh<MyItems> {
 
   public:
     MyMesh(char filename[],
@@ -294,16 +322,60 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
            bool b_useConnectivityPredictionFaces,
            bool b_useConnectivityPredictionEdges,
            bool b_allowConcaveFaces,
-           bool b_useTriangleMeshConnectivityPredictionFaces);
+           bool b_useTriangleMeshConnectivityPredictionFaces,
+           bool b_useRans,
+           bool b_useStaticTables,
+           unsigned i_modelPriorsId,
+           bool b_useWarmStart,
+           bool b_verbose);
 
     ~MyMesh();
 
+    void trainModelPriors(const char* psz_countsFilePath);
+
+    void recordSymbolStreams(const char* psz_filePath);
+
     void stepOperation();
 
     void batchOperation();
 
     void completeOperation();
 
+    inline bool isJobCompleted() const {
+        return b_jobCompleted;
+    }
+
+    // True if the job was stopped because the input data is invalid.
+    inline bool hasError() const {
+        return b_error;
+    }
+
+    // Reason why the job was stopped, empty without error.
+    inline const std::string& getErrorMessage() const {
+        return errorMessage;
+    }
+
+    inline unsigned getCurrentLodId() const {
+        return i_curOperationId;
+    }
+
+    inline const databuffer* getCompressedData() const {
+        return &dataBuffer;
+    }
+
+    // Level of detail index, empty until it has been completely read.
+    inline const std::vector<LodIndexEntry>& getLodIndex() const {
+        return lodIndex;
+    }
+
+    bool loadMesh(const std::vector<float>& vertices, const std::vector<uint32_t>& faces);
+
+    void getMesh(std::vector<float>& vertices, std::vector<uint32_t>& faces);
+
+    unsigned pushCompressedData(const char* p_data, size_t i_size);
+
+    void endCompressedData();
+
     Vector computeNormal(Facet_const_handle f) const;
 
     Vector computeVertexNormal(Halfedge_const_handle heh) const;
@@ -329,6 +401,8 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
     Point getPos(PointInt p) const;
 
     // Compression
+    bool beginCompression();
+
     void startNextCompresssionOp();
 
     void beginDecimationConquest();
@@ -349,6 +423,33 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
 
     void encodeRemovedVertices(unsigned i_operationId);
 
+    void encodeResidualSym(qsmodel* p_model, staticmodel* p_table, int residual, uint32_t* p_classCounts);
+
+    double staticModelCost(const std::vector<unsigned>& syms, unsigned i_nbModelSym, std::vector<uint4>& freqs);
+
+    double adaptiveModelCost(const std::vector<unsigned>& syms, const qsmodel* p_model, const int* p_priors);
+
+    void encodeStaticTable(staticmodel* p_model, const std::vector<uint4>& freqs);
+
+    // Entropy coding with the range coder or rANS.
+    void startEncoding();
+
+    unsigned doneEncoding();
+
+    int encodeSym(qsmodel* p_model, unsigned sym, unsigned i_lgTotFreq);
+
+    int encodeBinSym(binmodel* p_model, unsigned bit);
+
+    void encodeStaticSym(staticmodel* p_model, unsigned sym);
+
+    void encodeRawBits(uint32_t v, unsigned i_nbBits);
+
+    void encodeGamma(uint32_t v);
+
+    void encodeBit(unsigned b);
+
+    void encodeVarint(uint32_t v);
+
     void beginAdaptiveQuantization();
 
     void adaptiveQuantizationStep();
@@ -369,6 +470,8 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
     float removalError(Vertex_const_handle v, const std::vector<Vertex_const_handle>& polygon) const;
 
     // Decompression
+    void beginDecompression();
+
     void startNextDecompresssionOp();
 
     void beginUndecimationConquest();
@@ -385,6 +488,29 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
 
     void decodeGeometrySym(Halfedge_handle heh_gate, Face_handle fh);
 
+    int decodeResidualSym(qsmodel* p_model, staticmodel* p_table);
+
+    void decodeStaticTable(staticmodel* p_model);
+
+    // Entropy decoding with the range coder or rANS.
+    void startDecoding();
+
+    bool doneDecoding();
+
+    unsigned decodeSym(qsmodel* p_model, unsigned i_lgTotFreq);
+
+    unsigned decodeBinSym(binmodel* p_model);
+
+    unsigned decodeStaticSym(staticmodel* p_model);
+
+    uint32_t decodeRawBits(unsigned i_nbBits);
+
+    uint32_t decodeGamma();
+
+    unsigned decodeBit();
+
+    bool decodeVarint(uint32_t& i);
+
     void beginRemovedVertexCodingConquest();
 
     void determineGeometrySym(Halfedge_handle heh_gate, Face_handle fh);
@@ -394,7 +520,7 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
     void adaptiveUnquantizationStep();
 
     // Lifting
-    void lift(bool b_unlift);
+    bool lift(bool b_unlift);
 
     // Adaptive quantization
     float determineKg();
@@ -424,16 +550,41 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
 
     float faceSurface(Halfedge_handle heh) const;
 
-    void pushHehInit();
+    bool pushHehInit();
 
     void updateAvgSurfaces(bool b_split, float f_faceSurface);
 
     void updateAvgEdgeLen(bool b_original, float f_edgeLen);
 
+    // Element flag resets.
+    void resetVertexStates();
+
+    void resetHalfedgeStates();
+
+    void resetFaceStates();
+
+    void resetFaceProcessedFlags();
+
+    void compactElements();
+
+    void resetLodModels();
+
+    const int* lodStartFreqs(const qsmodel* p_model, const int* p_priors, int* p_freqs) const;
+
+    void restartModel(qsmodel* p_model, const int* p_priors);
+
+    void restartBinModels(binmodel* p_models, unsigned i_nbModels, const binmodel* p_priors);
+
+    unsigned faceSplitContext(Halfedge_handle h, float f_faceSurface) const;
+
+    unsigned insertedEdgeContext(Halfedge_handle h, float f_edgeLen) const;
+
+    unsigned residualContext(Halfedge_handle h, const VectorInt& laplacian);
+
     // IOs
     void writeCompressedData();
 
-    void readCompressedData();
+    bool readCompressedData();
 
     void writeFloat(float f);
 
@@ -443,17 +594,35 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
 
     int16_t readInt16();
 
+    void writeVarUInt64(uint64_t i);
+
+    uint64_t readVarUInt64();
+
+    size_t writeLodIndex();
+
+    bool readLodIndex();
+
+    void stopOnError(const char* psz_format, ...) __attribute__((format(printf, 2, 3)));
+
+    void printProgress(const char* psz_format, ...) const __attribute__((format(printf, 2, 3)));
+
+    bool isLodAvailable(unsigned i_lodId) const;
+
     void writeBaseMesh();
 
-    void readBaseMesh();
+    bool readBaseMesh();
 
     int writeCompressedFile() const;
 
+    int writeModelCountsFile() const;
+
+    int writeSymbolStreamsFile() const;
+
     int readCompressedFile(char psz_filePath[]);
 
-    void writeMeshOff(const char psz_filePath[]) const;
+    void writeMesh(const char psz_filePath[]);
 
-    void writeCurrentOperationMesh(std::string pathPrefix, unsigned i_id) const;
+    void writeCurrentOperationMesh(std::string pathPrefix, unsigned i_id);
 
     // Variables.
 
@@ -463,7 +632,11 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
 
     // Processing mode: 0 for compression and 1 for decompression.
     int i_mode;
-    bool b_jobCompleted;  // True if the job has been completed.
+    bool b_jobCompleted;       // True if the job has been completed.
+    bool b_error;              // True if the job was stopped by invalid input data.
+    std::string errorMessage;  // Reason why the job was stopped.
+    bool b_verbose;            // True to print the progress of the job on the standard output.
+    bool b_streaming;          // True if more compressed data can still be pushed.
 
     Operation operation;
     unsigned i_curDecimationId;
@@ -481,15 +654,21 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
 
     std::deque<unsigned> typeOfOperation;  // O - decimation, 1 - adaptive quantization.
 
-    // Geometry symbol list.
-    std::deque<std::deque<VectorInt>> geometrySym;
+    // Level of detail index. The first entry describes the base mesh.
+    std::vector<LodIndexEntry> lodIndex;
+
+    // Number of vertices and faces before each compression operation, in the operation order.
+    std::deque<std::pair<unsigned, unsigned>> lodMeshSizes;
+    unsigned i_nbVerticesBeforeOp;
+    unsigned i_nbFacesBeforeOp;
+
+    // Geometry symbol list: the residuals and their contexts.
+    std::deque<std::deque<std::pair<VectorInt, unsigned>>> geometrySym;
     std::deque<std::deque<unsigned>> adaptiveQuantSym;
 
-    // Connectivity symbol list.
+    // Connectivity symbol list: the symbols and their contexts.
     std::deque<std::deque<std::pair<unsigned, unsigned>>> connectFaceSym;
     std::deque<std::deque<std::pair<unsigned, unsigned>>> connectEdgeSym;
-    std::deque<unsigned> facesConnectPredictionUsed;
-    std::deque<unsigned> edgesConnectPredictionUsed;
 
     // Size used for the encoding.
     size_t connectivitySize;
@@ -498,6 +677,16 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
     // Number of vertices removed during current conquest.
     unsigned i_nbRemovedVertices;
 
+    // Sum of the degrees of the faces split during the current undecimation conquest.
+    size_t i_sumSplitFaceDegrees;
+
+    /* Data of the elements only used by some operations, indexed by the element ids.
+       The arrays are allocated when the operation begins and freed when it ends. */
+    std::vector<Point> removedVertexPositions;  // Removed vertex of each face, during the decimation.
+    std::vector<VectorInt> residuals;           // Residual of the removed vertex of each face.
+    std::vector<Point> oldPositions;            // Vertex positions before the adaptive quantization.
+    std::vector<uint8_t> quantCellIds;          // Cell of the old vertex positions, during the adaptive quantization.
+
     Point bbMin;
     Point bbMax;
     float f_bbVolume;
@@ -510,20 +699,43 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
     size_t i_nbVerticesInit;
     size_t i_nbFacetsInit;
 
-    // The compressed data;
-    char* p_data;
-    size_t dataOffset;  // the offset to read and write.
+    // The compressed data.
+    databuffer dataBuffer;
 
     std::string filePathOutput;
+    std::string outputMeshExtension;  // Extension, and so format, of the decompressed mesh files.
+
+    // Arrays of the decompressed mesh written in the files.
+    std::vector<float> outputVertices;
+    std::vector<uint32_t> outputFaces;
     unsigned i_decompPercentage;
 
     // Compression and decompression variables.
     rangecoder rangeCoder;
+    ranscoder ransCoder;
+
+    /* Range coder data models. They are allocated by the constructor
+       and reset in place for each level of detail. */
+    qsmodel alphaBetaModels[NB_RESIDUAL_CONTEXTS], gammaModels[NB_RESIDUAL_CONTEXTS], quantModel;
 
-    // Range coder data model.
-    qsmodel alphaBetaModel, gammaModel, quantModel, connectModel;
+    /* The residual models of a level of detail are selected by the context of each residual
+       when b_residualContexts is set, else the first ones are shared by all the residuals. */
+    bool b_residualContexts;
 
-    int alphaBetaMin, gammaMin;
+    // Sum and number of the curvature magnitudes of the current conquest, for the residual contexts.
+    uint64_t i_sumCurvatures;
+    unsigned i_nbCurvatures;
+
+    // Model to estimate the size of the residuals with adaptive models, on compression.
+    qsmodel costModel;
+
+    // Static residual models, used instead of the adaptive ones when b_staticResidualModels is set.
+    staticmodel alphaBetaTable, gammaTable;
+    bool b_staticResidualModels;
+
+    // Connectivity models, one per context.
+    binmodel faceConnectModels[NB_FACE_CONNECT_CONTEXTS];
+    binmodel edgeConnectModels[NB_EDGE_CONNECT_CONTEXTS];
 
     // Variable for connectivity prediction.
     float f_avgSurfaceFaceWithoutCenterRemoved;
@@ -538,11 +750,6 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
     unsigned i_nbInsertedEdges;
     unsigned i_nbOriginalEdges;
 
-    unsigned i_nbGoodPredictions;
-    bool b_predictionUsed;
-
-    std::filebuf fbDebug;
-    std::ostream osDebug;
 
     // Codec features status.
     bool b_useAdaptiveQuantization;
@@ -551,6 +758,20 @@ class MyMesh : public CGAL::Polyhedron_3<MyKernel, MyItems> {
     bool b_useConnectivityPredictionFaces;
     bool b_useConnectivityPredictionEdges;
     bool b_useTriangleMeshConnectivityPredictionFaces;
+    bool b_useRans;  // Entropy coding with rANS instead of the range coder.
+    bool b_useStaticTables;  // Static residual models allowed for the levels of detail.
+    bool b_useWarmStart;  // Models of a level of detail started from the ones of the previous level.
+
+    // Priors of the models, NULL for uniform models.
+    unsigned i_modelPriorsId;
+    const ModelPriors* p_modelPriors;
+
+    // Symbol counts of the models, gathered on compression to train the priors.
+    ModelCounts* p_modelCounts;
+    std::string modelCountsFilePath;
+
+    // File to record the symbol streams of the models in, on compression. Empty if not recording.
+    std::string symbolStreamsFilePath;
 };
 
 #endif
@@ -47,7 +47,7 @@ std::map<unsigned, unsigned> MyMesh::determineCellSymbols(Halfedge_handle heh_v,
     do {
         Vertex_const_handle vh_neighbor = heh->vertex();
         Point neightborPos =
-            b_compression && vh_neighbor->isConquered() ? vh_neighbor->getOldPos() : vh_neighbor->point();
+            b_compression && vh_neighbor->isConquered() ? oldPositions[vh_neighbor->id()] : vh_neighbor->point();
 
         unsigned i_level = i_quantBits - i_curQuantizationId;
         if (vh_neighbor->isConquered())
@@ -20,16 +20,39 @@
 #include "configuration.h"
 #include "frenetRotation.h"
 #include "mymesh.h"
+#include "symbolStreams.h"
 
 #include "math.h"
 
+// Base 2 log of v > 0, rounded down.
+static inline unsigned ilog2(uint32_t v) {
+    return 31 - __builtin_clz(v);
+}
+
+// Zigzag coding of a signed integer: 0, -1, 1, -2, 2... are coded 0, 1, 2, 3, 4...
+static inline uint32_t zigzag(int v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+// Class of a zigzag coded residual u and number of low bits of u left to code after it.
+static inline unsigned residualClass(uint32_t u, unsigned& i_nbRawBits) {
+    if (u < (1 << RESIDUAL_CLASS_DIRECT_BITS)) {
+        i_nbRawBits = 0;
+        return u;
+    }
+    unsigned i_nbBits = ilog2(u);
+    i_nbRawBits = i_nbBits - RESIDUAL_CLASS_MANTISSA_BITS;
+    return (1 << RESIDUAL_CLASS_DIRECT_BITS) + ((i_nbBits - RESIDUAL_CLASS_DIRECT_BITS) << RESIDUAL_CLASS_MANTISSA_BITS) +
+           ((u >> i_nbRawBits) & ((1 << RESIDUAL_CLASS_MANTISSA_BITS) - 1));
+}
+
 /**
  * Start the next compression operation.
  */
 void MyMesh::startNextCompresssionOp() {
     if (b_useAdaptiveQuantization) {
         unsigned i_estimatedQuant = round(-1.248 * log(determineKg()) - 0.954);
-        std::cout << "Estimated quantification for the current LOD: " << i_estimatedQuant << std::endl;
+        printProgress("Estimated quantification for the current LOD: %u\n", i_estimatedQuant);
 
         // Choose whether to start an adaptive quantization or a decimation operation.
         if (i_estimatedQuant < i_quantBits - i_curQuantizationId && i_quantBits - i_curQuantizationId > 4)
@@ -42,16 +65,13 @@ void MyMesh::startNextCompresssionOp() {
 }
 
 void MyMesh::beginDecimationConquest() {
-    printf("Begin decimation conquest n°%u.\n", i_curDecimationId);
-
-    for (MyMesh::Vertex_iterator vit = vertices_begin(); vit != vertices_end(); ++vit)
-        vit->resetState();
+    printProgress("Begin decimation conquest n°%u.\n", i_curDecimationId);
 
-    for (MyMesh::Halfedge_iterator hit = halfedges_begin(); hit != halfedges_end(); ++hit)
-        hit->resetState();
+    compactElements();
 
-    for (MyMesh::Face_iterator fit = facets_begin(); fit != facets_end(); ++fit)
-        fit->resetState();
+    resetVertexStates();
+    resetHalfedgeStates();
+    resetFaceStates();
 
     // Select the first gate to begin the decimation.
     size_t i_heInitId = (float)rand() / RAND_MAX * size_of_halfedges();
@@ -65,6 +85,10 @@ void MyMesh::beginDecimationConquest() {
     // Reset the number of removed vertices.
     i_nbRemovedVertices = 0;
 
+    // Save the mesh size, which is the size of the level of detail once decoded.
+    i_nbVerticesBeforeOp = size_of_vertices();
+    i_nbFacesBeforeOp = size_of_facets();
+
     // Set the current operation.
     operation = DecimationConquest;
 }
@@ -124,21 +148,26 @@ void MyMesh::decimationStep() {
         }
     }
 
-    printf("Decimation conquest completed.\n");
+    printProgress("Decimation conquest completed.\n");
 
     if (i_nbRemovedVertices == 0) {
         if (!b_testConvexity) {
             for (MyMesh::Vertex_iterator vit = vertices_begin(); vit != vertices_end(); ++vit) {
                 if (isRemovable(vit))
-                    printf("Still a vertex that can be removed !\n");
+                    printProgress("Still a vertex that can be removed !\n");
             }
 
-            printf("End of mesh compression.\n");
+            printProgress("End of mesh compression.\n");
             operation = Idle;
             b_jobCompleted = true;
             i_curDecimationId--;
             writeCompressedData();
-            writeCompressedFile();
+            if (!filePathOutput.empty() && writeCompressedFile() != 0)
+                stopOnError("Can't write the compressed file %s.", filePathOutput.c_str());
+            if (p_modelCounts && writeModelCountsFile() != 0)
+                stopOnError("Can't update the model counts file %s.", modelCountsFilePath.c_str());
+            if (!symbolStreamsFilePath.empty() && writeSymbolStreamsFile() != 0)
+                stopOnError("Can't write the symbol streams file %s.", symbolStreamsFilePath.c_str());
         }
         else {
             b_testConvexity = false;
@@ -200,9 +229,12 @@ MyMesh::Halfedge_handle MyMesh::vertexCut(Halfedge_handle startH) {
     Halfedge_handle hNewFace = erase_center_vertex(startH);
 
     // now mark the new face as having a removed vertex
-    hNewFace->facet()->setSplittable();
+    Face_handle fNew = hNewFace->facet();
+    fNew->setSplittable();
     // keep the removed vertex position.
-    hNewFace->facet()->setRemovedVertexPos(vPos);
+    if (fNew->id() >= removedVertexPositions.size())
+        removedVertexPositions.resize(size_of_facet_ids());
+    removedVertexPositions[fNew->id()] = vPos;
 
     // scan the outside halfedges of the new face and add them to the queue if the state of its face is unknown. Also
     // mark it as in_queue
@@ -227,7 +259,9 @@ MyMesh::Halfedge_handle MyMesh::vertexCut(Halfedge_handle startH) {
  * Determine the residuals to encode.
  */
 void MyMesh::determineResiduals() {
-    printf("Determine the geometry residuals.\n");
+    printProgress("Determine the geometry residuals.\n");
+
+    residuals.resize(size_of_facet_ids());
 
     // Add the first halfedge to the queue.
     pushHehInit();
@@ -256,8 +290,10 @@ void MyMesh::determineResiduals() {
         } while (hIt != h);
 
         if (f->isSplittable())
-            f->setResidual(getQuantizedPos(f->getRemovedVertexPos()) - getQuantizedPos(barycenter(h)));
+            residuals[f->id()] = getQuantizedPos(removedVertexPositions[f->id()]) - getQuantizedPos(barycenter(h));
     }
+
+    std::vector<Point>().swap(removedVertexPositions);
 }
 
 /**
@@ -266,25 +302,27 @@ void MyMesh::determineResiduals() {
 void MyMesh::beginRemovedVertexCodingConquest() {
     // Encode the type of operation on one bit.
     typeOfOperation.push_back(DECIMATION_OPERATION_ID);
+    lodMeshSizes.push_back(std::make_pair(i_nbVerticesBeforeOp, i_nbFacesBeforeOp));
 
-    for (MyMesh::Face_iterator fit = facets_begin(); fit != facets_end(); ++fit)
-        fit->resetProcessedFlag();
+    resetFaceProcessedFlags();
 
     // Add the first halfedge to the queue.
     pushHehInit();
 
     // Resize the vectors to add the current conquest symbols.
-    geometrySym.push_back(std::deque<VectorInt>());
+    geometrySym.push_back(std::deque<std::pair<VectorInt, unsigned>>());
     connectFaceSym.push_back(std::deque<std::pair<unsigned, unsigned>>());
 
+    i_sumCurvatures = 0;
+    i_nbCurvatures = 0;
+
     f_avgSurfaceFaceWithCenterRemoved = 0;
     f_avgSurfaceFaceWithoutCenterRemoved = 0;
     i_nbFacesWithCenterRemoved = 0;
     i_nbFacesWithoutCenterRemoved = 0;
-    i_nbGoodPredictions = 0;
 
     operation = RemovedVertexCoding;
-    printf("Removed vertex coding begining.\n");
+    printProgress("Removed vertex coding begining.\n");
 }
 
 /**
@@ -301,75 +339,16 @@ void MyMesh::RemovedVertexCodingStep() {
         if (f->isProcessed())
             continue;
 
-        // Determine face symbol.
-        unsigned sym, symPred;
+        // Determine the face symbol and its context.
         bool b_split = f->isSplittable();
         float f_faceSurface = faceSurface(h);
-
-        // Connectivity prediction.
-        float f_nbConqueredFaces = i_nbFacesWithCenterRemoved + i_nbFacesWithoutCenterRemoved;
-        if (b_useTriangleMeshConnectivityPredictionFaces && f_nbConqueredFaces != 0 &&
-            fabs(i_nbFacesWithCenterRemoved / f_nbConqueredFaces - i_nbFacesWithoutCenterRemoved / f_nbConqueredFaces) <
-                0.1) {
-            // Triangle mesh connectivity prediction in the case the average area are similar.
-            // Balance number between the splittable and non splittable neighbor faces.
-            int i_neighborBalance = 0;
-
-            // Compute the balance.
-            Halfedge_around_facet_const_circulator hit = h->facet_begin(), hit_end = hit;
-            CGAL_For_all(hit, hit_end) {
-                Face_const_handle fh = hit->opposite()->facet();
-
-                // If the current face is not already conquered,
-                // then it can't be taken into account for the prediction.
-                if (fh->isProcessed()) {
-                    if (fh->isSplittable())
-                        i_neighborBalance++;
-                    else if (fh->isUnsplittable())
-                        i_neighborBalance--;
-                }
-            }
-
-            // Determine the prediction symbol according to the balance.
-            if (i_neighborBalance >= 0 && !b_split || i_neighborBalance < 0 && b_split) {
-                symPred = 1;
-                i_nbGoodPredictions++;
-            }
-            else
-                symPred = 0;
-        }
-        else if ((f_avgSurfaceFaceWithCenterRemoved != 0 &&
-                  fabs(f_faceSurface - f_avgSurfaceFaceWithCenterRemoved) <=
-                      fabs(f_faceSurface - f_avgSurfaceFaceWithoutCenterRemoved)) ||
-                 f_avgSurfaceFaceWithoutCenterRemoved == 0) {
-            // If the surface of the face is closer than the average surface
-            // of the faces with a center vertex removed.
-            if (b_split) {
-                symPred = 1;
-                i_nbGoodPredictions++;
-            }
-            else
-                symPred = 0;
-        }
-        else {
-            // If the surface of the face is closer than the average surface
-            // of the faces without a center vertex removed.
-            if (!b_split) {
-                symPred = 1;
-                i_nbGoodPredictions++;
-            }
-            else
-                symPred = 0;
-        }
-
-        // No connectivity prediction.
-        sym = b_split ? 1 : 0;
+        unsigned i_context = faceSplitContext(h, f_faceSurface);
 
         // Update the average surfaces.
         updateAvgSurfaces(b_split, f_faceSurface);
 
-        // Push the symbols.
-        connectFaceSym[i_curDecimationId].push_back(std::pair<unsigned, unsigned>(sym, symPred));
+        // Push the symbol.
+        connectFaceSym[i_curDecimationId].push_back(std::pair<unsigned, unsigned>(b_split, i_context));
 
         // Determine the geometry symbol.
         if (b_split)
@@ -391,17 +370,9 @@ void MyMesh::RemovedVertexCodingStep() {
         return;
     }
 
-    printf("Removed vertex coding completed.\n");
-    float f_nb = i_nbFacesWithCenterRemoved > i_nbFacesWithoutCenterRemoved ? i_nbFacesWithCenterRemoved :
-                                                                              i_nbFacesWithoutCenterRemoved;
+    printProgress("Removed vertex coding completed.\n");
 
-    unsigned usePrediction = (float)i_nbGoodPredictions / size_of_facets() > f_nb / size_of_facets() ? 1 : 0;
-    facesConnectPredictionUsed.push_back(usePrediction);
-
-#if 0
-    printf("Encoding ratios: %.2f %.2f\n",
-           (float)i_nbGoodPredictions / size_of_facets(), f_nb / size_of_facets());
-#endif
+    std::vector<VectorInt>().swap(residuals);
 
     operation = InsertedEdgeCoding;
     beginInsertedEdgeCoding();
@@ -426,11 +397,14 @@ void MyMesh::determineGeometrySym(Halfedge_handle heh_gate, Face_handle fh) {
         determineFrenetFrame(heh_gate, normal, t1, t2);
 #endif
 
+    VectorInt laplacian = avgLaplacianVect(heh_gate);
+    unsigned i_context = residualContext(heh_gate, laplacian);
+
     VectorInt distQuant;
     if (b_useCurvaturePrediction)
-        distQuant = fh->getResidual() + avgLaplacianVect(heh_gate) / INV_ALPHA;
+        distQuant = residuals[fh->id()] + laplacian / INV_ALPHA;
     else
-        distQuant = fh->getResidual();
+        distQuant = residuals[fh->id()];
 
 #ifdef USE_BIJECTION
     VectorInt frenetCoord = frenetRotation(distQuant, t1, t2, normal);
@@ -438,9 +412,9 @@ void MyMesh::determineGeometrySym(Halfedge_handle heh_gate, Face_handle fh) {
 
     // Store the geometry symbols.
 #ifdef USE_BIJECTION
-    geometrySym[i_curDecimationId].push_back(frenetCoord);
+    geometrySym[i_curDecimationId].push_back(std::make_pair(frenetCoord, i_context));
 #else
-    geometrySym[i_curDecimationId].push_back(distQuant);
+    geometrySym[i_curDecimationId].push_back(std::make_pair(distQuant, i_context));
 #endif
 }
 
@@ -455,13 +429,12 @@ void MyMesh::beginInsertedEdgeCoding() {
     f_avgOriginalEdgesLength = 0;
     i_nbInsertedEdges = 0;
     i_nbOriginalEdges = 0;
-    i_nbGoodPredictions = 0;
 
     // Resize the vector to add the current conquest symbols.
     connectEdgeSym.push_back(std::deque<std::pair<unsigned, unsigned>>());
 
     operation = InsertedEdgeCoding;
-    printf("Inserted edge coding begining.\n");
+    printProgress("Inserted edge coding begining.\n");
 }
 
 /**
@@ -491,60 +464,24 @@ void MyMesh::InsertedEdgeCodingStep() {
         // Don't write a symbol if the two faces of an egde are unsplitable.
         bool b_toCode = h->facet()->isUnsplittable() && h->opposite()->facet()->isUnsplittable() ? false : true;
 
-        // Determine the edge symbol.
-        unsigned sym, symPred;
+        // Determine the edge symbol and its context.
         bool b_original = h->isOriginal();
         float f_edgeLen = edgeLen(h);
-
-        // Connectivity prediction.
-        if ((f_avgOriginalEdgesLength != 0 &&
-             fabs(f_edgeLen - f_avgOriginalEdgesLength) <= fabs(f_edgeLen - f_avgInsertedEdgesLength)) ||
-            f_avgInsertedEdgesLength == 0) {
-            if (b_original) {
-                symPred = 1;
-                i_nbGoodPredictions++;
-            }
-            else
-                symPred = 0;
-        }
-        else {
-            if (!b_original) {
-                symPred = 1;
-                i_nbGoodPredictions++;
-            }
-            else
-                symPred = 0;
-        }
-
-        if (b_original)
-            sym = 0;
-        else
-            sym = 1;
+        unsigned i_context = b_toCode ? insertedEdgeContext(h, f_edgeLen) : 0;
 
         // Update the average edge lengths.
         updateAvgEdgeLen(b_original, f_edgeLen);
 
         // Store the symbol if needed.
         if (b_toCode)
-            connectEdgeSym[i_curDecimationId].push_back(std::pair<unsigned, unsigned>(sym, symPred));
+            connectEdgeSym[i_curDecimationId].push_back(std::pair<unsigned, unsigned>(!b_original, i_context));
 
         return;
     }
 
-    printf("Inserted edge coding completed.\n");
-
-    float f_nb = i_nbOriginalEdges > i_nbInsertedEdges ? i_nbOriginalEdges : i_nbInsertedEdges;
-
-    unsigned usePrediction =
-        (float)i_nbGoodPredictions * 2 / size_of_halfedges() > f_nb * 2 / size_of_halfedges() ? 1 : 0;
-    edgesConnectPredictionUsed.push_back(usePrediction);
-
-#if 0
-    printf("Encoding ratios: %.2f %.2f\n",
-           (float)i_nbGoodPredictions * 2 / size_of_halfedges(), f_nb * 2 / size_of_halfedges());
-#endif
+    printProgress("Inserted edge coding completed.\n");
 
-    printf("Number of vertices: %lu - Number of faces: %lu\n", size_of_vertices(), size_of_facets());
+    printProgress("Number of vertices: %lu - Number of faces: %lu\n", size_of_vertices(), size_of_facets());
 
     i_curDecimationId++;  // Increment the current decimation operation id.
     i_curOperationId++;
@@ -556,40 +493,26 @@ void MyMesh::InsertedEdgeCodingStep() {
  */
 void MyMesh::encodeInsertedEdges(unsigned i_operationId) {
     // Start the encoder.
-    start_encoding(&rangeCoder, 0, 0);
+    startEncoding();
 
     std::deque<std::pair<unsigned, unsigned>>& symbols = connectEdgeSym[i_operationId];
 
     assert(symbols.size() > 0);
 
-    if (b_useConnectivityPredictionEdges)
-        b_predictionUsed = edgesConnectPredictionUsed[i_operationId];
-    else
-        b_predictionUsed = false;
-
-    // Encode if the prediction was used or not.
-    encode_shift(&rangeCoder, 1, b_predictionUsed, 1);
-
-    // Init the connectivity range coder.
-    initqsmodel(&connectModel, 2, 10, 1 << 9, NULL, 1);
+    // Init the connectivity models.
+    restartBinModels(edgeConnectModels, NB_EDGE_CONNECT_CONTEXTS, p_modelPriors ? p_modelPriors->edgeConnect : NULL);
 
     unsigned i_len = symbols.size();
     for (unsigned i = 0; i < i_len; ++i) {
-        unsigned sym = b_predictionUsed ? symbols[i].second : symbols[i].first;
-
-        // Encode the symbol.
-        int syfreq, ltfreq;
-        qsgetfreq(&connectModel, sym, &syfreq, &ltfreq);
-        encode_shift(&rangeCoder, syfreq, ltfreq, 10);
-        // Update the model.
-        qsupdate(&connectModel, sym);
+        // Encode the symbol with the model of its context.
+        encodeBinSym(&edgeConnectModels[symbols[i].second], symbols[i].first);
+        if (p_modelCounts)
+            p_modelCounts->edgeConnect[symbols[i].second][symbols[i].first]++;
     }
 
-    unsigned i_size = done_encoding(&rangeCoder);
+    unsigned i_size = doneEncoding();
 
     connectivitySize += i_size * 8;
-    // Destroy the model.
-    deleteqsmodel(&connectModel);
 }
 
 /**
@@ -597,143 +520,117 @@ void MyMesh::encodeInsertedEdges(unsigned i_operationId) {
  */
 void MyMesh::encodeRemovedVertices(unsigned i_operationId) {
     // Start the encoder.
-    start_encoding(&rangeCoder, 0, 0);
+    startEncoding();
 
     // Encode the type of operation on one bit.
-    encode_shift(&rangeCoder, 1, DECIMATION_OPERATION_ID, 1);
+    encodeBit(DECIMATION_OPERATION_ID);
 
     std::deque<std::pair<unsigned, unsigned>>& connSym = connectFaceSym[i_operationId];
-    std::deque<VectorInt>& geomSym = geometrySym[i_operationId];
-
-    if (b_useConnectivityPredictionFaces)
-        b_predictionUsed = facesConnectPredictionUsed[i_operationId];
-    else
-        b_predictionUsed = false;
-
-    // Encode if the prediction was used or not.
-    encode_shift(&rangeCoder, 1, b_predictionUsed, 1);
+    std::deque<std::pair<VectorInt, unsigned>>& geomSym = geometrySym[i_operationId];
 
     unsigned i_lenGeom = geomSym.size();
     unsigned i_lenConn = connSym.size();
     assert(i_lenGeom > 0);
     assert(i_lenConn > 0);
 
-    // Determine the min and max values for the geometry coding.
-    alphaBetaMin = geomSym[0].x();
-    int alphaBetaMax = geomSym[0].x();
-
-#ifdef USE_BIJECTION
-    gammaMin = geomSym[0].z();
-    int gammaMax = geomSym[0].z();
-#endif
+    // Size of the connectivity data in bits, accumulated from the model frequencies.
+    double f_connectivityBits = 0;
 
+    // The residual classes, also by context, and the size of the bits coded without modelling.
+    std::vector<unsigned> alphaBetaSyms, gammaSyms;
+    std::vector<unsigned> alphaBetaContextSyms[NB_RESIDUAL_CONTEXTS], gammaContextSyms[NB_RESIDUAL_CONTEXTS];
+    double f_rawBits = 0;
     for (unsigned i = 0; i < i_lenGeom; ++i) {
-        VectorInt v = geomSym[i];
-
-        if (v.x() < alphaBetaMin)
-            alphaBetaMin = v.x();
-        if (v.y() < alphaBetaMin)
-            alphaBetaMin = v.y();
+        unsigned i_context = geomSym[i].second;
+        for (unsigned j = 0; j < 3; ++j) {
+            unsigned i_nbRawBits;
+            unsigned i_class = residualClass(zigzag(geomSym[i].first[j]), i_nbRawBits);
+            f_rawBits += i_nbRawBits;
 #ifdef USE_BIJECTION
-        if (v.z() < gammaMin)
-            gammaMin = v.z();
-#else
-        if (v.z() < alphaBetaMin)
-            alphaBetaMin = v.z();
+            if (j == 2) {
+                gammaSyms.push_back(i_class);
+                gammaContextSyms[i_context].push_back(i_class);
+                continue;
+            }
 #endif
+            alphaBetaSyms.push_back(i_class);
+            alphaBetaContextSyms[i_context].push_back(i_class);
+        }
+    }
 
-        if (v.x() > alphaBetaMax)
-            alphaBetaMax = v.x();
-        if (v.y() > alphaBetaMax)
-            alphaBetaMax = v.y();
+    /* Choose between the shared and the context adaptive residual models from their estimated sizes.
+       The contexts only pay off once each of their models has enough residuals to adapt. */
+    const int* p_alphaBetaPriors = p_modelPriors ? p_modelPriors->alphaBeta : NULL;
+    double f_sharedBits = adaptiveModelCost(alphaBetaSyms, &alphaBetaModels[0], p_alphaBetaPriors);
+    double f_contextBits = 0;
+    for (unsigned i = 0; i < NB_RESIDUAL_CONTEXTS; ++i)
+        f_contextBits += adaptiveModelCost(alphaBetaContextSyms[i], &alphaBetaModels[i], p_alphaBetaPriors);
 #ifdef USE_BIJECTION
-        if (v.z() > gammaMax)
-            gammaMax = v.z();
-#else
-        if (v.z() > alphaBetaMax)
-            alphaBetaMax = v.z();
+    const int* p_gammaPriors = p_modelPriors ? p_modelPriors->gamma : NULL;
+    f_sharedBits += adaptiveModelCost(gammaSyms, &gammaModels[0], p_gammaPriors);
+    for (unsigned i = 0; i < NB_RESIDUAL_CONTEXTS; ++i)
+        f_contextBits += adaptiveModelCost(gammaContextSyms[i], &gammaModels[i], p_gammaPriors);
 #endif
-    }
-
-    // Check that we have at least two geometry symbols.
-    unsigned alphaBetaRange = std::max(alphaBetaMax - alphaBetaMin + 1, 2);
+    b_residualContexts = f_contextBits < f_sharedBits;
+
+    /* Choose between the adaptive and the static residual models.
+       The static models are only used when their symbols and their table are smaller than the adaptive models. */
+    std::vector<uint4> alphaBetaFreqs, gammaFreqs;
+    b_staticResidualModels = false;
+    if (b_useStaticTables) {
+        double f_staticBits = f_rawBits + staticModelCost(alphaBetaSyms, RESIDUAL_NB_CLASSES, alphaBetaFreqs);
 #ifdef USE_BIJECTION
-    unsigned gammaRange = std::max(gammaMax - gammaMin + 1, 2);
+        f_staticBits += staticModelCost(gammaSyms, RESIDUAL_NB_CLASSES, gammaFreqs);
 #endif
+        double f_adaptiveBits = f_rawBits + std::min(f_sharedBits, f_contextBits);
+        b_staticResidualModels = f_staticBits < f_adaptiveBits;
+    }
 
-    // assert(alphaBetaRange < 1 << 12);
-    // assert(gammaRange < 1 << 12);
-
-    // Write the min value and the range.
-    int16_t i16_min;
-
-    assert(alphaBetaMin >= -(1 << 14) && alphaBetaMin <= (1 << 14));
-    i16_min = alphaBetaMin;
-    encode_short(&rangeCoder, *(uint16_t*)&i16_min);
-    assert(alphaBetaRange < (1 << 14));
-    encode_short(&rangeCoder, alphaBetaRange);
-
+    // Encode the model type and init the models.
+    encodeBit(b_staticResidualModels);
+    if (b_staticResidualModels) {
+        encodeStaticTable(&alphaBetaTable, alphaBetaFreqs);
 #ifdef USE_BIJECTION
-    assert(gammaMin >= -(1 << 14) && gammaMin <= (1 << 14));
-    i16_min = gammaMin;
-    encode_short(&rangeCoder, *(uint16_t*)&i16_min);
-    assert(gammaRange < (1 << 14));
-    encode_short(&rangeCoder, gammaRange);
+        encodeStaticTable(&gammaTable, gammaFreqs);
 #endif
-
-    // Range coder to only measure the size of the connectivity data.
-    size_t* p_dataOffsetMes = new size_t;
-    *p_dataOffsetMes = 0;
-    char* p_dataMes = new char[BUFFER_SIZE];
-    rangecoder rangeCoderMes;
-    rangeCoderMes.p_data = p_dataMes;
-    rangeCoderMes.p_dataOffset = p_dataOffsetMes;
-    start_encoding(&rangeCoderMes, 0, 0);
-
-    // Init the models.
-    initqsmodel(&alphaBetaModel, alphaBetaRange, 18, 1 << 17, NULL, 1);
+    }
+    else {
+        encodeBit(b_residualContexts);
+        unsigned i_nbModels = b_residualContexts ? NB_RESIDUAL_CONTEXTS : 1;
+        for (unsigned i = 0; i < i_nbModels; ++i) {
+            restartModel(&alphaBetaModels[i], p_alphaBetaPriors);
 #ifdef USE_BIJECTION
-    initqsmodel(&gammaModel, gammaRange, 18, 1 << 17, NULL, 1);
+            restartModel(&gammaModels[i], p_gammaPriors);
 #endif
-    initqsmodel(&connectModel, 2, 10, 1 << 9, NULL, 1);
+        }
+    }
+    restartBinModels(faceConnectModels, NB_FACE_CONNECT_CONTEXTS, p_modelPriors ? p_modelPriors->faceConnect : NULL);
 
     unsigned k = 0;
     for (unsigned i = 0; i < i_lenConn; ++i) {
-        // Encode the connectivity.
-        unsigned sym = b_predictionUsed ? connSym[i].second : connSym[i].first;
+        // Encode the connectivity with the model of its context.
         bool b_split = connSym[i].first;
-
-        int syfreq, ltfreq;
-        // Encode the symbol.
-        qsgetfreq(&connectModel, sym, &syfreq, &ltfreq);
-        encode_shift(&rangeCoder, syfreq, ltfreq, 10);
-        encode_shift(&rangeCoderMes, syfreq, ltfreq, 10);
-        // Update the model.
-        qsupdate(&connectModel, sym);
+        int syfreq = encodeBinSym(&faceConnectModels[connSym[i].second], b_split);
+        f_connectivityBits += BINMODEL_LG_TOTF - log2(syfreq);
+        if (p_modelCounts)
+            p_modelCounts->faceConnect[connSym[i].second][b_split]++;
 
         // Encode the geometry if necessary.
         if (b_split) {
-            VectorInt v = geomSym[k];
+            VectorInt v = geomSym[k].first;
+            unsigned i_model = b_residualContexts ? geomSym[k].second : 0;
 
             for (unsigned j = 0; j < 3; ++j) {
 #ifdef USE_BIJECTION
                 if (j < 2) {
 #endif
-                    sym = v[j] - alphaBetaMin;
                     // Encode the alpha and beta symbols.
-                    qsgetfreq(&alphaBetaModel, sym, &syfreq, &ltfreq);
-                    encode_shift(&rangeCoder, syfreq, ltfreq, 18);
-                    // Update the alpha and beta model.
-                    qsupdate(&alphaBetaModel, sym);
+                    encodeResidualSym(&alphaBetaModels[i_model], &alphaBetaTable, v[j], p_modelCounts ? p_modelCounts->alphaBeta : NULL);
 #ifdef USE_BIJECTION
                 }
                 else {
-                    sym = v[j] - gammaMin;
                     // Encode the gamma symbol.
-                    qsgetfreq(&gammaModel, sym, &syfreq, &ltfreq);
-                    encode_shift(&rangeCoder, syfreq, ltfreq, 18);
-                    // Update the gamma model.
-                    qsupdate(&gammaModel, sym);
+                    encodeResidualSym(&gammaModels[i_model], &gammaTable, v[j], p_modelCounts ? p_modelCounts->gamma : NULL);
                 }
 #endif
             }
@@ -741,21 +638,202 @@ void MyMesh::encodeRemovedVertices(unsigned i_operationId) {
         }
     }
 
-    unsigned i_size = done_encoding(&rangeCoder);
-    unsigned i_sizeConn = done_encoding(&rangeCoderMes);
+    unsigned i_size = doneEncoding();
+    unsigned i_sizeConn = std::min(i_size, (unsigned)ceil(f_connectivityBits / 8));
 
     geometrySize += (i_size - i_sizeConn) * 8;
     connectivitySize += i_sizeConn * 8;
+}
 
-    // Destroy the models.
-    deleteqsmodel(&alphaBetaModel);
-#ifdef USE_BIJECTION
-    deleteqsmodel(&gammaModel);
-#endif
-    deleteqsmodel(&connectModel);
+/**
+ * Encode a residual and update its model.
+ * The residual is zigzag coded, then coded as its class with the model
+ * followed by its remaining low bits without modelling.
+ * The static model p_table is used instead of p_model when the residual models are static.
+ * \param p_classCounts the class counts to update to train the priors, NULL if not training.
+ */
+void MyMesh::encodeResidualSym(qsmodel* p_model, staticmodel* p_table, int residual, uint32_t* p_classCounts) {
+    unsigned i_nbRawBits;
+    uint32_t u = zigzag(residual);
+    unsigned i_class = residualClass(u, i_nbRawBits);
+    if (p_classCounts)
+        p_classCounts[i_class]++;
+
+    if (b_staticResidualModels)
+        encodeStaticSym(p_table, i_class);
+    else
+        encodeSym(p_model, i_class, 18);
+
+    encodeRawBits(u, i_nbRawBits);
+}
+
+/**
+ * Estimate the size of symbols coded with a static model, including its table.
+ * \param freqs the frequencies of the static model.
+ * \return the size in bits, infinite if the model can not be static.
+ */
+double MyMesh::staticModelCost(const std::vector<unsigned>& syms, unsigned i_nbModelSym, std::vector<uint4>& freqs) {
+    std::vector<uint4> counts(i_nbModelSym, 0);
+    for (unsigned i = 0; i < syms.size(); ++i)
+        counts[syms[i]]++;
+
+    freqs.resize(i_nbModelSym);
+    if (!normalizefreqs(counts.data(), i_nbModelSym, STATIC_MODEL_LG_TOTF, freqs.data()))
+        return HUGE_VAL;
+
+    // Symbols.
+    double f_bits = 0;
+    for (unsigned i = 0; i < i_nbModelSym; ++i)
+        if (counts[i] != 0)
+            f_bits += counts[i] * (STATIC_MODEL_LG_TOTF - log2(freqs[i]));
+
+    // Table.
+    unsigned i_nbUsedSym = 0;
+    int i_prevSym = -1;
+    for (unsigned i = 0; i < i_nbModelSym; ++i) {
+        if (freqs[i] != 0) {
+            f_bits += 2 * ilog2(i - i_prevSym) + 1 + 2 * ilog2(freqs[i]) + 1;
+            i_prevSym = i;
+            i_nbUsedSym++;
+        }
+    }
+    return f_bits + 8 * (ilog2(i_nbUsedSym) / 7 + 1);
+}
 
-    delete[] p_dataMes;
-    delete p_dataOffsetMes;
+/**
+ * Estimate the size of symbols coded with an adaptive model, restarted by restartModel().
+ * \param p_model the model.
+ * \param p_priors the priors of the model, NULL for a uniform model.
+ * \return the size in bits.
+ */
+double MyMesh::adaptiveModelCost(const std::vector<unsigned>& syms, const qsmodel* p_model, const int* p_priors) {
+    int startFreqs[RESIDUAL_NB_CLASSES];
+    resetqsmodel(&costModel, lodStartFreqs(p_model, p_priors, startFreqs));
+
+    double f_bits = 0;
+    for (unsigned i = 0; i < syms.size(); ++i) {
+        int syfreq, ltfreq;
+        qsgetfreq(&costModel, syms[i], &syfreq, &ltfreq);
+        f_bits += 18 - log2(syfreq);
+        qsupdate(&costModel, syms[i]);
+    }
+    return f_bits;
+}
+
+/**
+ * Encode the table of a static model and init the model.
+ * The symbols of non-zero frequency are coded by the gap from the previous one, then their frequency.
+ */
+void MyMesh::encodeStaticTable(staticmodel* p_model, const std::vector<uint4>& freqs) {
+    unsigned i_nbUsedSym = 0;
+    for (unsigned i = 0; i < freqs.size(); ++i)
+        i_nbUsedSym += freqs[i] != 0;
+    encodeVarint(i_nbUsedSym);
+
+    int i_prevSym = -1;
+    for (unsigned i = 0; i < freqs.size(); ++i) {
+        if (freqs[i] != 0) {
+            encodeGamma(i - i_prevSym);
+            encodeGamma(freqs[i]);
+            i_prevSym = i;
+        }
+    }
+
+    resetstaticmodel(p_model, freqs.data());
+}
+
+// Start the entropy encoder at the current offset of the compressed data.
+void MyMesh::startEncoding() {
+    if (b_useRans)
+        rans_start_encoding(&ransCoder);
+    else
+        start_encoding(&rangeCoder, 0, 0);
+}
+
+/**
+ * Stop the entropy encoder.
+ * \return the number of written bytes.
+ */
+unsigned MyMesh::doneEncoding() {
+    return b_useRans ? rans_done_encoding(&ransCoder) : done_encoding(&rangeCoder);
+}
+
+/**
+ * Encode a symbol with a model of total frequency 1 << i_lgTotFreq and update the model.
+ * \return the frequency of the symbol before the update.
+ */
+int MyMesh::encodeSym(qsmodel* p_model, unsigned sym, unsigned i_lgTotFreq) {
+    int syfreq, ltfreq;
+    qsgetfreq(p_model, sym, &syfreq, &ltfreq);
+    if (b_useRans)
+        rans_encode_shift(&ransCoder, syfreq, ltfreq, i_lgTotFreq);
+    else
+        encode_shift(&rangeCoder, syfreq, ltfreq, i_lgTotFreq);
+    qsupdate(p_model, sym);
+    return syfreq;
+}
+
+/**
+ * Encode a bit with an adaptive binary model and update the model.
+ * \return the frequency of the bit before the update.
+ */
+int MyMesh::encodeBinSym(binmodel* p_model, unsigned bit) {
+    int syfreq, ltfreq;
+    binmodelgetfreq(p_model, bit, &syfreq, &ltfreq);
+    if (b_useRans)
+        rans_encode_shift(&ransCoder, syfreq, ltfreq, BINMODEL_LG_TOTF);
+    else
+        encode_shift(&rangeCoder, syfreq, ltfreq, BINMODEL_LG_TOTF);
+    binmodelupdate(p_model, bit);
+    return syfreq;
+}
+
+// Encode a symbol with a static model.
+void MyMesh::encodeStaticSym(staticmodel* p_model, unsigned sym) {
+    int syfreq, ltfreq;
+    staticgetfreq(p_model, sym, &syfreq, &ltfreq);
+    if (b_useRans)
+        rans_encode_shift(&ransCoder, syfreq, ltfreq, p_model->lg_totf);
+    else
+        encode_shift(&rangeCoder, syfreq, ltfreq, p_model->lg_totf);
+}
+
+// Encode a bit without modelling.
+void MyMesh::encodeBit(unsigned b) {
+    if (b_useRans)
+        rans_encode_shift(&ransCoder, 1, b, 1);
+    else
+        encode_shift(&rangeCoder, 1, b, 1);
+}
+
+// Encode the i_nbBits < 32 low bits of v without modelling, by chunks of at most 16 bits.
+void MyMesh::encodeRawBits(uint32_t v, unsigned i_nbBits) {
+    while (i_nbBits > 0) {
+        unsigned i_nbChunkBits = std::min(i_nbBits, 16u);
+        i_nbBits -= i_nbChunkBits;
+        uint32_t chunk = (v >> i_nbBits) & ((1 << i_nbChunkBits) - 1);
+        if (b_useRans)
+            rans_encode_shift(&ransCoder, 1, chunk, i_nbChunkBits);
+        else
+            encode_shift(&rangeCoder, 1, chunk, i_nbChunkBits);
+    }
+}
+
+// Encode an integer v >= 1 with the Elias gamma code.
+void MyMesh::encodeGamma(uint32_t v) {
+    unsigned i_nbBits = ilog2(v);
+    for (unsigned i = 0; i < i_nbBits; ++i)
+        encodeBit(0);
+    encodeBit(1);
+    encodeRawBits(v, i_nbBits);
+}
+
+// Encode an unsigned integer on a variable number of bytes.
+void MyMesh::encodeVarint(uint32_t v) {
+    if (b_useRans)
+        rans_encode_varint(&ransCoder, v);
+    else
+        encode_varint(&rangeCoder, v);
 }
 
 /**
@@ -765,21 +843,24 @@ void MyMesh::encodeRemovedVertices(unsigned i_operationId) {
  * Geometry-guided Progressive Lossless 3D Mesh Coding with Octree (OT) Decomposition
  */
 void MyMesh::beginAdaptiveQuantization() {
-    printf("Begin adaptive quantization conquest n°%u.\n", i_curQuantizationId);
+    printProgress("Begin adaptive quantization conquest n°%u.\n", i_curQuantizationId);
 
-    for (MyMesh::Vertex_iterator vit = vertices_begin(); vit != vertices_end(); ++vit)
-        vit->resetState();
+    resetVertexStates();
 
     // Add the first halfedge to the queue.
     pushHehInit();
 
     typeOfOperation.push_back(QUANTIZATION_OPERATION_ID);
+    lodMeshSizes.push_back(std::make_pair((unsigned)size_of_vertices(), (unsigned)size_of_facets()));
 
     adaptiveQuantSym.push_back(std::deque<unsigned>());
 
     // Increment the quantization step.
     i_curQuantizationId++;
 
+    oldPositions.resize(size_of_vertex_ids());
+    quantCellIds.resize(size_of_vertex_ids());
+
     // Frist step: quantize all the mesh vertex position and store their cell id.
     for (Vertex_iterator vit = vertices_begin(); vit != vertices_end(); ++vit) {
         Point oldPos = vit->point();
@@ -795,8 +876,8 @@ void MyMesh::beginAdaptiveQuantization() {
         for (unsigned i = 0; i < 3; ++i)
             i_quantCellId += oldPos[i] <= newPos[i] ? 0 : (1 << i);
 
-        vit->setOldPos(oldPos);
-        vit->setQuantCellId(i_quantCellId);
+        oldPositions[vit->id()] = oldPos;
+        quantCellIds[vit->id()] = i_quantCellId;
     }
 
     // Set the current operation.
@@ -829,13 +910,16 @@ void MyMesh::adaptiveQuantizationStep() {
 
         std::map<unsigned, unsigned> cellMap = determineCellSymbols(h, true);
 
-        unsigned sym = cellMap[vh->getQuantCellId()];
+        unsigned sym = cellMap[quantCellIds[vh->id()]];
         adaptiveQuantSym[i_curQuantizationId - 1].push_back(sym);
 
         return;
     }
 
-    printf("Adaptive quantization completed.\n");
+    printProgress("Adaptive quantization completed.\n");
+
+    std::vector<Point>().swap(oldPositions);
+    std::vector<uint8_t>().swap(quantCellIds);
 
     // writeCurrentOperationMesh(std::string("mesh_"), i_curOperationId);
     i_curOperationId++;
@@ -847,41 +931,120 @@ void MyMesh::adaptiveQuantizationStep() {
  * Encode a adaptive quantization operation.
  */
 void MyMesh::encodeAdaptiveQuantization(std::deque<unsigned>& symbols) {
-    // Init the connectivity range coder.
-    initqsmodel(&quantModel, 8, 12, 2000, NULL, 1);
-    start_encoding(&rangeCoder, 0, 0);
+    // Reset the model.
+    restartModel(&quantModel, p_modelPriors ? p_modelPriors->quant : NULL);
+    startEncoding();
 
     // Encode the type of operation on one bit.
-    encode_shift(&rangeCoder, 1, QUANTIZATION_OPERATION_ID, 1);
+    encodeBit(QUANTIZATION_OPERATION_ID);
 
-    unsigned i_nbSymbols[8] = {0};
+    unsigned i_nbSymbols[QUANT_MODEL_NB_SYMBOLS] = {0};
 
     unsigned i_len = symbols.size();
-    std::cout << "Nb vertices: " << i_len << std::endl;
+    printProgress("Nb vertices: %u\n", i_len);
     assert(i_len > 0);
     for (unsigned i = 0; i < i_len; ++i) {
         unsigned sym = symbols[i];
         i_nbSymbols[sym]++;
+        if (p_modelCounts)
+            p_modelCounts->quant[sym]++;
 
-        // Encode the symbol.
-        int syfreq, ltfreq;
-        qsgetfreq(&quantModel, sym, &syfreq, &ltfreq);
-        encode_shift(&rangeCoder, syfreq, ltfreq, 12);
-        // Update the model.
-        qsupdate(&quantModel, sym);
+        // Encode the symbol and update the model.
+        encodeSym(&quantModel, sym, 12);
     }
 
-    unsigned i_size = done_encoding(&rangeCoder);
+    unsigned i_size = doneEncoding();
 
 #if 0
-    printf("Symbol distribution");
-    for (unsigned i = 0; i < 8; ++i)
-        printf("symb %u: %u\n", i, i_nbSymbols[i]);
-    printf("Size for the adaptive quantization encoding: %u.\n", i_size);
+    printProgress("Symbol distribution");
+    for (unsigned i = 0; i < QUANT_MODEL_NB_SYMBOLS; ++i)
+        printProgress("symb %u: %u\n", i, i_nbSymbols[i]);
+    printProgress("Size for the adaptive quantization encoding: %u.\n", i_size);
 #endif
 
     geometrySize += i_size * 8;
+}
+
+// Empty symbol stream of the models of a kind.
+static SymbolStream modelStream(const char* psz_name, const qsmodel& model, unsigned i_nbContexts) {
+    SymbolStream stream;
+    stream.name = psz_name;
+    stream.i_nbSymbols = model.n;
+    stream.i_lgTotFreq = ilog2(model.cf[model.n]);
+    stream.i_rescale = model.targetrescale;
+    stream.i_nbContexts = i_nbContexts;
+    return stream;
+}
+
+// Empty symbol stream of binary models.
+static SymbolStream binModelStream(const char* psz_name, unsigned i_nbContexts) {
+    SymbolStream stream;
+    stream.name = psz_name;
+    stream.i_nbSymbols = 2;
+    stream.i_lgTotFreq = BINMODEL_LG_TOTF;
+    stream.i_rescale = 0;
+    stream.i_nbContexts = i_nbContexts;
+    return stream;
+}
+
+/**
+ * Write the symbols given to the models, in the coding order of the levels of detail.
+ * The geometry streams hold the residual classes, without their raw bits.
+ * \return 0 on success.
+ */
+int MyMesh::writeSymbolStreamsFile() const {
+    SymbolStream alphaBeta = modelStream("alphaBeta", alphaBetaModels[0], NB_RESIDUAL_CONTEXTS);
+#ifdef USE_BIJECTION
+    SymbolStream gamma = modelStream("gamma", gammaModels[0], NB_RESIDUAL_CONTEXTS);
+#else
+    SymbolStream gamma;
+#endif
+    SymbolStream faceConnect = binModelStream("faceConnect", NB_FACE_CONNECT_CONTEXTS);
+    SymbolStream edgeConnect = binModelStream("edgeConnect", NB_EDGE_CONNECT_CONTEXTS);
+    SymbolStream quant = modelStream("quant", quantModel, 1);
+
+    for (unsigned i = geometrySym.size(); i-- > 0;) {
+        for (const std::pair<VectorInt, unsigned>& sym : geometrySym[i]) {
+            for (unsigned j = 0; j < 3; ++j) {
+                unsigned i_nbRawBits;
+#ifdef USE_BIJECTION
+                SymbolStream& stream = j < 2 ? alphaBeta : gamma;
+#else
+                SymbolStream& stream = alphaBeta;
+#endif
+                stream.symbols.push_back(residualClass(zigzag(sym.first[j]), i_nbRawBits));
+                stream.contexts.push_back(sym.second);
+            }
+        }
+    }
+
+    for (unsigned i = connectFaceSym.size(); i-- > 0;) {
+        for (const std::pair<unsigned, unsigned>& sym : connectFaceSym[i]) {
+            faceConnect.symbols.push_back(sym.first);
+            faceConnect.contexts.push_back(sym.second);
+        }
+    }
+
+    for (unsigned i = connectEdgeSym.size(); i-- > 0;) {
+        for (const std::pair<unsigned, unsigned>& sym : connectEdgeSym[i]) {
+            edgeConnect.symbols.push_back(sym.first);
+            edgeConnect.contexts.push_back(sym.second);
+        }
+    }
+
+    for (unsigned i = adaptiveQuantSym.size(); i-- > 0;) {
+        for (unsigned sym : adaptiveQuantSym[i]) {
+            quant.symbols.push_back(sym);
+            quant.contexts.push_back(0);
+        }
+    }
+
+    std::vector<SymbolStream> streams;
+    for (const SymbolStream* p_stream : {&alphaBeta, &gamma, &faceConnect, &edgeConnect, &quant}) {
+        if (!p_stream->symbols.empty())
+            streams.push_back(*p_stream);
+    }
 
-    // Destroy the model.
-    deleteqsmodel(&quantModel);
+    printProgress("Write the symbol streams file %s.\n", symbolStreamsFilePath.c_str());
+    return writeSymbolStreams(symbolStreamsFilePath.c_str(), streams) ? 0 : 1;
 }
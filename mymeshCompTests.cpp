@@ -33,7 +33,7 @@ bool MyMesh::willViolateManifold(const std::vector<Halfedge_const_handle>& polyg
     for (unsigned i = 0; i < i_degree; ++i) {
         Halfedge_around_vertex_const_circulator Hvc = polygon[i]->vertex()->vertex_begin();
         Halfedge_around_vertex_const_circulator Hvc_end = Hvc;
-        CGAL_For_all(Hvc, Hvc_end) {
+        do {
             // Look if the current vertex belongs to the patch.
             Vertex_const_handle vh = Hvc->opposite()->vertex();
             for (unsigned j = 0; j < i_degree; ++j) {
@@ -47,7 +47,7 @@ bool MyMesh::willViolateManifold(const std::vector<Halfedge_const_handle>& polyg
                         return true;
                 }
             }
-        }
+        } while (++Hvc != Hvc_end);
     }
 
     return false;
@@ -21,33 +21,62 @@
 #include "frenetRotation.h"
 #include "mymesh.h"
 
+/**
+ * Decode the base mesh and skip the levels of detail that are not convex.
+ */
+void MyMesh::beginDecompression() {
+    if (!readCompressedData())
+        return;
+
+    if (i_mode == DECOMPRESSION_MODE_WRITE_ALL_ID)
+        writeCurrentOperationMesh(filePathOutput, 0);
+
+    // Set the vertices of the edge that is the departure of the coding and decoding conquests.
+    vh_departureConquest[0] = vertices_begin();
+    vh_departureConquest[1] = ++vertices_begin();
+
+    if (i_levelNotConvexId - i_nbDecimations > 0) {
+        // Decompress until the first convex LOD is reached or its data is missing.
+        while (!b_jobCompleted && i_curDecimationId < i_levelNotConvexId && isLodAvailable(i_curOperationId + 1))
+            batchOperation();
+        batchOperation();
+    }
+}
+
 /**
  * Start the next decompression operation.
  */
 void MyMesh::startNextDecompresssionOp() {
-    if ((float)i_curOperationId / (i_nbQuantizations + i_nbDecimations) * 100 >= i_decompPercentage) {
-        std::cout << "End of mesh decompression." << std::endl;
-        std::cout << "Nb of LODs decompressed: " << i_curOperationId + 1 << std::endl;
-        std::cout << "First level to display: " << i_levelNotConvexId << std::endl;
+    // Wait until the data of the next level of detail has been pushed.
+    if (b_streaming && (lodIndex.empty() || !isLodAvailable(i_curOperationId + 1)))
+        return;
 
-        writeMeshOff(std::string(filePathOutput + ".off").c_str());
+    if ((float)i_curOperationId / (i_nbQuantizations + i_nbDecimations) * 100 >= i_decompPercentage ||
+        !isLodAvailable(i_curOperationId + 1)) {
+        printProgress("End of mesh decompression.\n");
+        printProgress("Nb of LODs decompressed: %u\n", i_curOperationId + 1);
+        printProgress("First level to display: %u\n", i_levelNotConvexId);
 
-        for (MyMesh::Halfedge_iterator hit = halfedges_begin(); hit != halfedges_end(); ++hit)
-            hit->resetState();
+        if (!filePathOutput.empty())
+            writeMesh(std::string(filePathOutput + outputMeshExtension).c_str());
 
-        for (MyMesh::Face_iterator fit = facets_begin(); fit != facets_end(); ++fit)
-            fit->resetState();
+        resetHalfedgeStates();
+        resetFaceStates();
 
         operation = Idle;
         b_jobCompleted = true;
     }
     else {
-        // Start the decoder.
-        start_decoding(&rangeCoder);
-
-        // Read the operation type.
-        unsigned char i_operationType = decode_culshift(&rangeCoder, 1);
-        decode_update(&rangeCoder, 1, i_operationType, 1 << 1);
+        // Start the decoder at the beginning of the level of detail data.
+        dataBuffer.offset = lodIndex[i_curOperationId + 1].i_offset;
+        startDecoding();
+
+        // Read the operation type, which must be the one of the index.
+        unsigned char i_operationType = decodeBit();
+        if (i_operationType != lodIndex[i_curOperationId + 1].i_operationType) {
+            stopOnError("The compressed data is corrupted.");
+            return;
+        }
 
         switch (i_operationType) {
             case DECIMATION_OPERATION_ID: beginUndecimationConquest(); break;
@@ -61,49 +90,55 @@ void MyMesh::startNextDecompresssionOp() {
  * Begin an undecimation conquest.
  */
 void MyMesh::beginUndecimationConquest() {
-    printf("Begin undecimation conquest n°%u.\n", i_curDecimationId);
+    printProgress("Begin undecimation conquest n°%u.\n", i_curDecimationId);
+
+    // The new elements are appended in the conquest order, which already keeps the neighbours
+    // close in memory. Sorting them along a space-filling curve does not speed up the conquests,
+    // so the elements are only compacted.
+    compactElements();
 
-    for (MyMesh::Halfedge_iterator hit = halfedges_begin(); hit != halfedges_end(); ++hit)
-        hit->resetState();
+    resetHalfedgeStates();
+    resetFaceStates();
 
-    for (MyMesh::Face_iterator fit = facets_begin(); fit != facets_end(); ++fit)
-        fit->resetState();
+    residuals.resize(size_of_facet_ids());
 
     // Add the first halfedge to the queue.
-    pushHehInit();
+    if (!pushHehInit()) {
+        stopOnError("The compressed data is corrupted.");
+        return;
+    }
 
     operation = RemovedVertexCoding;
-    printf("Removed vertex decoding begining.\n");
+    printProgress("Removed vertex decoding begining.\n");
 
     f_avgSurfaceFaceWithCenterRemoved = 0;
     f_avgSurfaceFaceWithoutCenterRemoved = 0;
     i_nbFacesWithCenterRemoved = 0;
     i_nbFacesWithoutCenterRemoved = 0;
-    i_nbGoodPredictions = 0;
-
-    // Read if the prediction was used or not.
-    unsigned test = decode_culshift(&rangeCoder, 1);
-    b_predictionUsed = test;
-    decode_update(&rangeCoder, 1, b_predictionUsed, 1 << 1);
+    i_sumSplitFaceDegrees = 0;
 
-    // Read the min values and the ranges.
-    uint16_t i16_min;
-    i16_min = decode_short(&rangeCoder);
-    alphaBetaMin = *(int16_t*)&i16_min;
-    unsigned alphaBetaRange = decode_short(&rangeCoder);
+    i_sumCurvatures = 0;
+    i_nbCurvatures = 0;
 
+    // Read the model type and init the models.
+    b_staticResidualModels = decodeBit();
+    if (b_staticResidualModels) {
+        decodeStaticTable(&alphaBetaTable);
 #ifdef USE_BIJECTION
-    i16_min = decode_short(&rangeCoder);
-    gammaMin = *(int16_t*)&i16_min;
-    unsigned gammaRange = decode_short(&rangeCoder);
+        decodeStaticTable(&gammaTable);
 #endif
-
-    // Init the range coder models.
-    initqsmodel(&alphaBetaModel, alphaBetaRange, 18, 1 << 17, NULL, 0);
+    }
+    else {
+        b_residualContexts = decodeBit();
+        unsigned i_nbModels = b_residualContexts ? NB_RESIDUAL_CONTEXTS : 1;
+        for (unsigned i = 0; i < i_nbModels; ++i) {
+            restartModel(&alphaBetaModels[i], p_modelPriors ? p_modelPriors->alphaBeta : NULL);
 #ifdef USE_BIJECTION
-    initqsmodel(&gammaModel, gammaRange, 18, 1 << 17, NULL, 0);
+            restartModel(&gammaModels[i], p_modelPriors ? p_modelPriors->gamma : NULL);
 #endif
-    initqsmodel(&connectModel, 2, 10, 1 << 9, NULL, 0);
+        }
+    }
+    restartBinModels(faceConnectModels, NB_FACE_CONNECT_CONTEXTS, p_modelPriors ? p_modelPriors->faceConnect : NULL);
 
     // Set the current operation.
     operation = UndecimationConquest;
@@ -123,16 +158,12 @@ void MyMesh::undecimationStep() {
         if (f->isConquered())
             continue;
 
-        // Decode the face symbol.
-        int syfreq, ltfreq;
-        ltfreq = decode_culshift(&rangeCoder, 10);
-        unsigned sym = qsgetsym(&connectModel, ltfreq);
-        qsgetfreq(&connectModel, sym, &syfreq, &ltfreq);
-        decode_update(&rangeCoder, syfreq, ltfreq, 1 << 10);
-        // Update the model.
-        qsupdate(&connectModel, sym);
+        // Decode the face symbol with the model of its context.
+        float f_faceSurface = faceSurface(h);
+        bool b_split = decodeBinSym(&faceConnectModels[faceSplitContext(h, f_faceSurface)]);
 
         // Add the other halfedges to the queue
+        unsigned i_degree = 0;
         Halfedge_handle hIt = h;
         do {
             Halfedge_handle hOpp = hIt->opposite();
@@ -140,84 +171,30 @@ void MyMesh::undecimationStep() {
             if (!hOpp->facet()->isConquered())
                 gateQueue.push(hOpp);
             hIt = hIt->next();
+            i_degree++;
         } while (hIt != h);
 
-        bool b_split;
-        float f_faceSurface = faceSurface(h);
-
-        if (b_predictionUsed) {
-            // Connectivity prediction.
-            float f_nbConqueredFaces = i_nbFacesWithCenterRemoved + i_nbFacesWithoutCenterRemoved;
-            if (b_useTriangleMeshConnectivityPredictionFaces && f_nbConqueredFaces != 0 &&
-                fabs(i_nbFacesWithCenterRemoved / f_nbConqueredFaces -
-                     i_nbFacesWithoutCenterRemoved / f_nbConqueredFaces) < 0.1) {
-                // Triangle mesh connectivity prediction in the case the average area are similar.
-                // Balance number between the splittable and non splittable neighbor faces.
-                int i_neighborBalance = 0;
-
-                // Compute the balance.
-                Halfedge_around_facet_const_circulator hit = h->facet_begin(), hit_end = hit;
-                CGAL_For_all(hit, hit_end) {
-                    Face_const_handle fh = hit->opposite()->facet();
-
-                    // If the current face is not already conquered,
-                    // then it can't be taken into account for the prediction.
-                    if (fh->isConquered()) {
-                        if (fh->isSplittable())
-                            i_neighborBalance++;
-                        else
-                            i_neighborBalance--;
-                    }
-                }
-
-                // Determine if the face is split or not.
-                if (sym == 1)
-                    b_split = i_neighborBalance >= 0 ? false : true;
-                else
-                    b_split = i_neighborBalance >= 0 ? true : false;
-            }
-            else if ((f_avgSurfaceFaceWithCenterRemoved != 0 &&
-                      fabs(f_faceSurface - f_avgSurfaceFaceWithCenterRemoved) <=
-                          fabs(f_faceSurface - f_avgSurfaceFaceWithoutCenterRemoved)) ||
-                     f_avgSurfaceFaceWithoutCenterRemoved == 0) {
-                // If the surface of the face is closer than the average surface
-                // of the faces with a center vertex removed.
-                b_split = sym == 1 ? true : false;
-            }
-            else {
-                // If the surface of the face is closer than the average surface
-                // of the faces without a center vertex removed.
-                b_split = sym == 1 ? false : true;
-            }
-        }
-        else {
-            // No connectivity prediction.
-            b_split = sym == 1 ? true : false;
-        }
-
         // Update the average surfaces.
         updateAvgSurfaces(b_split, f_faceSurface);
 
         // Decode the geometry symbol.
-        if (b_split)
+        if (b_split) {
             decodeGeometrySym(h, f);
+            i_sumSplitFaceDegrees += i_degree;
+        }
         else
             f->setUnsplittable();
 
         return;
     }
 
-    printf("Removed vertex decoding completed.\n");
+    printProgress("Removed vertex decoding completed.\n");
 
     // Stop the decoder.
-    done_decoding(&rangeCoder);
-
-    // Delete the models.
-    deleteqsmodel(&connectModel);
-    deleteqsmodel(&alphaBetaModel);
-#ifdef USE_BIJECTION
-    deleteqsmodel(&gammaModel);
-#endif
+    if (!doneDecoding()) {
+        stopOnError("The compressed data is corrupted.");
+        return;
+    }
 
     operation = InsertedEdgeDecoding;
 
@@ -232,22 +209,18 @@ void MyMesh::beginInsertedEdgeDecoding() {
     pushHehInit();
 
     operation = InsertedEdgeDecoding;
-    printf("Inserted edge decoding begining.\n");
+    printProgress("Inserted edge decoding begining.\n");
 
     f_avgInsertedEdgesLength = 0;
     f_avgOriginalEdgesLength = 0;
     i_nbInsertedEdges = 0;
     i_nbOriginalEdges = 0;
 
-    // Init the range coder models.
-    initqsmodel(&connectModel, 2, 10, 1 << 9, NULL, 0);
+    // Init the connectivity models.
+    restartBinModels(edgeConnectModels, NB_EDGE_CONNECT_CONTEXTS, p_modelPriors ? p_modelPriors->edgeConnect : NULL);
 
     // Start the decoder.
-    start_decoding(&rangeCoder);
-
-    // Read if the prediction was used or not.
-    b_predictionUsed = decode_culshift(&rangeCoder, 1);
-    decode_update(&rangeCoder, 1, b_predictionUsed, 1 << 1);
+    startDecoding();
 }
 
 /**
@@ -282,29 +255,8 @@ void MyMesh::InsertedEdgeDecodingStep() {
         // Test if there is a symbol for this edge.
         // There is no symbol if the two faces of an egde are unsplitable.
         if (h->facet()->isSplittable() || h->opposite()->facet()->isSplittable()) {
-            // Decode the edge symbol.
-            int syfreq, ltfreq;
-            ltfreq = decode_culshift(&rangeCoder, 10);
-            unsigned sym = qsgetsym(&connectModel, ltfreq);
-            qsgetfreq(&connectModel, sym, &syfreq, &ltfreq);
-            decode_update(&rangeCoder, syfreq, ltfreq, 1 << 10);
-            // Update the model.
-            qsupdate(&connectModel, sym);
-
-            // Determine if the edge is original or not.
-
-            if (b_predictionUsed) {
-                if ((f_avgOriginalEdgesLength != 0 &&
-                     fabs(f_edgeLen - f_avgOriginalEdgesLength) <= fabs(f_edgeLen - f_avgInsertedEdgesLength)) ||
-                    f_avgInsertedEdgesLength == 0) {
-                    b_original = sym == 1 ? true : false;
-                }
-                else {
-                    b_original = sym == 1 ? false : true;
-                }
-            }
-            else
-                b_original = sym == 0 ? true : false;
+            // Decode the edge symbol with the model of its context.
+            b_original = !decodeBinSym(&edgeConnectModels[insertedEdgeContext(h, f_edgeLen)]);
 
             // Mark the edge to be removed.
             if (!b_original)
@@ -317,22 +269,26 @@ void MyMesh::InsertedEdgeDecodingStep() {
         return;
     }
 
-    printf("Inserted edge decoding completed.\n");
+    printProgress("Inserted edge decoding completed.\n");
 
     // Stop the decoder.
-    done_decoding(&rangeCoder);
-
-    // Delete the models.
-    deleteqsmodel(&connectModel);
+    if (!doneDecoding()) {
+        stopOnError("The compressed data is corrupted.");
+        return;
+    }
 
-    if (b_useLiftingScheme)
-        lift(true);  // Unlift the vertex positions.
+    // Unlift the vertex positions.
+    if (b_useLiftingScheme && !lift(true)) {
+        stopOnError("The compressed data is corrupted.");
+        return;
+    }
 
     insertRemovedVertices();
+    std::vector<VectorInt>().swap(residuals);
 
     removeInsertedEdges();
 
-    printf("Number of vertices: %lu - Number of faces: %lu\n", size_of_vertices(), size_of_facets());
+    printProgress("Number of vertices: %lu - Number of faces: %lu\n", size_of_vertices(), size_of_facets());
 
     if (i_mode == DECOMPRESSION_MODE_WRITE_ALL_ID)
         writeCurrentOperationMesh(filePathOutput, i_curOperationId + 1);
@@ -346,7 +302,12 @@ void MyMesh::InsertedEdgeDecodingStep() {
  * Insert center vertices.
  */
 void MyMesh ::insertRemovedVertices() {
-    printf("Insert removed vertices.\n");
+    printProgress("Insert removed vertices.\n");
+
+    // Reserve the elements of the inserted vertices: each split face of degree d
+    // gets a vertex, d edges and d - 1 new faces.
+    reserve(size_of_vertex_ids() + i_nbFacesWithCenterRemoved, size_of_halfedge_ids() + 2 * i_sumSplitFaceDegrees,
+            size_of_facet_ids() + i_sumSplitFaceDegrees - i_nbFacesWithCenterRemoved);
 
     // Add the first halfedge to the queue.
     pushHehInit();
@@ -378,17 +339,17 @@ void MyMesh ::insertRemovedVertices() {
 
         if (f->isSplittable()) {
             // Insert the vertex.
-            Point p = getPos(getQuantizedPos(barycenter(h)) + f->getResidual());
+            Point p = getPos(getQuantizedPos(barycenter(h)) + residuals[f->id()]);
             Halfedge_handle hehNewVertex = create_center_vertex(h);
             hehNewVertex->vertex()->point() = p;
 
             // Mark all the created edges as new.
             Halfedge_around_vertex_circulator Hvc = hehNewVertex->vertex_begin();
             Halfedge_around_vertex_circulator Hvc_end = Hvc;
-            CGAL_For_all(Hvc, Hvc_end) {
+            do {
                 Hvc->setNew();
                 Hvc->opposite()->setNew();
-            }
+            } while (++Hvc != Hvc_end);
         }
     }
 }
@@ -397,7 +358,7 @@ void MyMesh ::insertRemovedVertices() {
  * Remove all the marked edges.
  */
 void MyMesh::removeInsertedEdges() {
-    printf("Remove inserted edges.\n");
+    printProgress("Remove inserted edges.\n");
 
     for (MyMesh::Halfedge_iterator hit = halfedges_begin(); hit != halfedges_end(); ++hit) {
         if (hit->isAdded())
@@ -405,6 +366,166 @@ void MyMesh::removeInsertedEdges() {
     }
 }
 
+/**
+ * Decode a residual written by encodeResidualSym() and update its model.
+ * The static model p_table is used instead of p_model when the residual models are static.
+ */
+int MyMesh::decodeResidualSym(qsmodel* p_model, staticmodel* p_table) {
+    unsigned i_class = b_staticResidualModels ? decodeStaticSym(p_table) : decodeSym(p_model, 18);
+
+    uint32_t u = i_class;
+    if (i_class >= (1 << RESIDUAL_CLASS_DIRECT_BITS)) {
+        unsigned i_exponentMantissa = i_class - (1 << RESIDUAL_CLASS_DIRECT_BITS);
+        unsigned i_nbBits = RESIDUAL_CLASS_DIRECT_BITS + (i_exponentMantissa >> RESIDUAL_CLASS_MANTISSA_BITS);
+        unsigned i_nbRawBits = i_nbBits - RESIDUAL_CLASS_MANTISSA_BITS;
+        uint32_t mantissa = (1 << RESIDUAL_CLASS_MANTISSA_BITS) | (i_exponentMantissa & ((1 << RESIDUAL_CLASS_MANTISSA_BITS) - 1));
+        u = mantissa << i_nbRawBits | decodeRawBits(i_nbRawBits);
+    }
+
+    // Undo the zigzag coding.
+    return (int)(u >> 1) ^ -(int)(u & 1);
+}
+
+/**
+ * Decode the table of a static model written by encodeStaticTable() and init the model.
+ */
+void MyMesh::decodeStaticTable(staticmodel* p_model) {
+    uint4 freqs[RESIDUAL_NB_CLASSES] = {0};
+
+    // A corrupted table stops the job. The model is still set, so that the current step can end.
+    uint32_t i_nbUsedSym;
+    if (!decodeVarint(i_nbUsedSym) || i_nbUsedSym > RESIDUAL_NB_CLASSES) {
+        stopOnError("The static table is corrupted.");
+        i_nbUsedSym = 0;
+    }
+    unsigned i_sym = (unsigned)-1;
+    for (unsigned i = 0; i < i_nbUsedSym; ++i) {
+        i_sym += decodeGamma();
+        uint32_t i_freq = decodeGamma();
+        // Ignore the symbols out of the model of a corrupted table.
+        if (i_sym < RESIDUAL_NB_CLASSES)
+            freqs[i_sym] = i_freq;
+    }
+
+    resetstaticmodel(p_model, freqs);
+}
+
+// Start the entropy decoder at the current offset of the compressed data, in the current level of detail.
+void MyMesh::startDecoding() {
+    const LodIndexEntry& lod = lodIndex[i_curOperationId + 1];
+    if (b_useRans)
+        rans_start_decoding(&ransCoder, lod.i_offset + lod.i_size);
+    else
+        start_decoding(&rangeCoder);
+}
+
+/**
+ * Stop the entropy decoder.
+ * \return false if the decoder found the data corrupted.
+ */
+bool MyMesh::doneDecoding() {
+    if (b_useRans)
+        return rans_done_decoding(&ransCoder) == 0;
+
+    done_decoding(&rangeCoder);
+    return true;
+}
+
+// Decode a symbol with a model of total frequency 1 << i_lgTotFreq and update the model.
+unsigned MyMesh::decodeSym(qsmodel* p_model, unsigned i_lgTotFreq) {
+    int syfreq, ltfreq;
+    if (b_useRans) {
+        unsigned sym = qsgetsym(p_model, rans_decode_culshift(&ransCoder, i_lgTotFreq));
+        qsgetfreq(p_model, sym, &syfreq, &ltfreq);
+        rans_decode_update(&ransCoder, syfreq, ltfreq, i_lgTotFreq);
+        qsupdate(p_model, sym);
+        return sym;
+    }
+
+    unsigned sym = qsgetsym(p_model, decode_culshift(&rangeCoder, i_lgTotFreq));
+    qsgetfreq(p_model, sym, &syfreq, &ltfreq);
+    decode_update(&rangeCoder, syfreq, ltfreq, 1 << i_lgTotFreq);
+    qsupdate(p_model, sym);
+    return sym;
+}
+
+// Decode a bit with an adaptive binary model and update the model.
+unsigned MyMesh::decodeBinSym(binmodel* p_model) {
+    int bit = b_useRans ? rans_decode_bit_shift(&ransCoder, *p_model, BINMODEL_LG_TOTF) :
+                          decode_bit_shift(&rangeCoder, *p_model, BINMODEL_LG_TOTF);
+    binmodelupdate(p_model, bit);
+    return bit;
+}
+
+// Decode a symbol with a static model.
+unsigned MyMesh::decodeStaticSym(staticmodel* p_model) {
+    int syfreq, ltfreq;
+    if (b_useRans) {
+        unsigned sym = staticgetsym(p_model, rans_decode_culshift(&ransCoder, p_model->lg_totf));
+        staticgetfreq(p_model, sym, &syfreq, &ltfreq);
+        rans_decode_update(&ransCoder, syfreq, ltfreq, p_model->lg_totf);
+        return sym;
+    }
+
+    unsigned sym = staticgetsym(p_model, decode_culshift(&rangeCoder, p_model->lg_totf));
+    staticgetfreq(p_model, sym, &syfreq, &ltfreq);
+    decode_update(&rangeCoder, syfreq, ltfreq, 1 << p_model->lg_totf);
+    return sym;
+}
+
+// Decode a bit without modelling.
+unsigned MyMesh::decodeBit() {
+    if (b_useRans) {
+        unsigned b = rans_decode_culshift(&ransCoder, 1);
+        rans_decode_update(&ransCoder, 1, b, 1);
+        return b;
+    }
+
+    unsigned b = decode_culshift(&rangeCoder, 1);
+    decode_update(&rangeCoder, 1, b, 1 << 1);
+    return b;
+}
+
+// Decode i_nbBits < 32 bits written by encodeRawBits().
+uint32_t MyMesh::decodeRawBits(unsigned i_nbBits) {
+    uint32_t v = 0;
+    while (i_nbBits > 0) {
+        unsigned i_nbChunkBits = std::min(i_nbBits, 16u);
+        i_nbBits -= i_nbChunkBits;
+        uint32_t chunk;
+        if (b_useRans) {
+            chunk = rans_decode_culshift(&ransCoder, i_nbChunkBits);
+            rans_decode_update(&ransCoder, 1, chunk, i_nbChunkBits);
+        }
+        else {
+            chunk = decode_culshift(&rangeCoder, i_nbChunkBits);
+            decode_update(&rangeCoder, 1, chunk, 1 << i_nbChunkBits);
+        }
+        v = v << i_nbChunkBits | chunk;
+    }
+    return v;
+}
+
+// Decode an integer written by encodeGamma().
+uint32_t MyMesh::decodeGamma() {
+    unsigned i_nbBits = 0;
+    while (!decodeBit() && i_nbBits < 31)
+        i_nbBits++;
+
+    return 1u << i_nbBits | decodeRawBits(i_nbBits);
+}
+
+/**
+ * Decode an unsigned integer written by encodeVarint().
+ * \return false if the integer is corrupted.
+ */
+bool MyMesh::decodeVarint(uint32_t& i) {
+    uint4 v;
+    int i_ret = b_useRans ? rans_decode_varint(&ransCoder, &v) : decode_varint(&rangeCoder, &v);
+    i = v;
+    return i_ret == 0;
+}
+
 /**
  * Decode the geometry symbols.
  */
@@ -423,33 +544,22 @@ void MyMesh::decodeGeometrySym(Halfedge_handle heh_gate, Face_handle fh) {
         determineFrenetFrame(heh_gate, normal, t1, t2);
 #endif
 
+    VectorInt laplacian = avgLaplacianVect(heh_gate);
+    unsigned i_context = residualContext(heh_gate, laplacian);
+    unsigned i_model = b_residualContexts ? i_context : 0;
+
     int coord[3];
     for (unsigned i = 0; i < 3; ++i) {
-        int syfreq, ltfreq;
 #ifdef USE_BIJECTION
         if (i < 2) {
 #endif
             // Decode the alpha and beta symbols.
-            ltfreq = decode_culshift(&rangeCoder, 18);
-            unsigned sym = qsgetsym(&alphaBetaModel, ltfreq);
-            qsgetfreq(&alphaBetaModel, sym, &syfreq, &ltfreq);
-            decode_update(&rangeCoder, syfreq, ltfreq, 1 << 18);
-            // Update the alpha and beta model.
-            qsupdate(&alphaBetaModel, sym);
-            // Store the value.
-            coord[i] = alphaBetaMin + sym;
+            coord[i] = decodeResidualSym(&alphaBetaModels[i_model], &alphaBetaTable);
 #ifdef USE_BIJECTION
         }
         else {
-            // Encode the gamma symbol.
-            ltfreq = decode_culshift(&rangeCoder, 18);
-            unsigned sym = qsgetsym(&gammaModel, ltfreq);
-            qsgetfreq(&gammaModel, sym, &syfreq, &ltfreq);
-            decode_update(&rangeCoder, syfreq, ltfreq, 1 << 18);
-            // Update the gamma model.
-            qsupdate(&gammaModel, sym);
-            // Store the value.
-            coord[i] = gammaMin + sym;
+            // Decode the gamma symbol.
+            coord[i] = decodeResidualSym(&gammaModels[i_model], &gammaTable);
         }
 #endif
     }
@@ -464,28 +574,30 @@ void MyMesh::decodeGeometrySym(Halfedge_handle heh_gate, Face_handle fh) {
 #endif
 
     if (b_useCurvaturePrediction)
-        correction = correction - avgLaplacianVect(heh_gate) / INV_ALPHA;
+        correction = correction - laplacian / INV_ALPHA;
 
     fh->setSplittable();
-    fh->setResidual(correction);
+    residuals[fh->id()] = correction;
 }
 
 /**
  * Begin the adaptive unquantization operation.
  */
 void MyMesh::beginAdaptiveUnquantization() {
-    printf("Adaptive unquantization begining.\n");
+    printProgress("Adaptive unquantization begining.\n");
 
-    for (MyMesh::Vertex_iterator vit = vertices_begin(); vit != vertices_end(); ++vit)
-        vit->resetState();
+    resetVertexStates();
 
     // Add the first halfedge to the queue.
-    pushHehInit();
+    if (!pushHehInit()) {
+        stopOnError("The compressed data is corrupted.");
+        return;
+    }
 
     operation = AdaptiveUnquantization;
 
-    // Init the range coder models.
-    initqsmodel(&quantModel, 8, 12, 2000, NULL, 0);
+    // Reset the range coder model.
+    restartModel(&quantModel, p_modelPriors ? p_modelPriors->quant : NULL);
 }
 
 /**
@@ -513,13 +625,7 @@ void MyMesh::adaptiveUnquantizationStep() {
         }
 
         // Decode the vertex symbol.
-        int syfreq, ltfreq;
-        ltfreq = decode_culshift(&rangeCoder, 12);
-        unsigned sym = qsgetsym(&quantModel, ltfreq);
-        qsgetfreq(&quantModel, sym, &syfreq, &ltfreq);
-        decode_update(&rangeCoder, syfreq, ltfreq, 1 << 12);
-        // Update the model.
-        qsupdate(&quantModel, sym);
+        unsigned sym = decodeSym(&quantModel, 12);
 
         std::map<unsigned, unsigned> cellMap = determineCellSymbols(h, false);
         unsigned i_cellId = cellMap[sym];
@@ -547,10 +653,10 @@ void MyMesh::adaptiveUnquantizationStep() {
     }
 
     // Stop the decoder.
-    done_decoding(&rangeCoder);
-
-    // Delete the model.
-    deleteqsmodel(&quantModel);
+    if (!doneDecoding()) {
+        stopOnError("The compressed data is corrupted.");
+        return;
+    }
 
     if (i_mode == DECOMPRESSION_MODE_WRITE_ALL_ID)
         writeCurrentOperationMesh(filePathOutput, i_curOperationId + 1);
@@ -558,7 +664,7 @@ void MyMesh::adaptiveUnquantizationStep() {
     i_curQuantizationId--;
     i_curOperationId++;
 
-    printf("Adaptive unquantization completed.\n");
+    printProgress("Adaptive unquantization completed.\n");
 
     operation = Idle;
 }
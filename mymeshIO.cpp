@@ -17,11 +17,14 @@
  * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
  *****************************************************************************/
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 
+#include "bitStream.h"
 #include "configuration.h"
+#include "meshWriter.h"
 #include "mymesh.h"
-#include "mymeshBaseBuilder.h"
 
 /**
  * Write the compressed data to the buffer.
@@ -30,16 +33,27 @@ void MyMesh::writeCompressedData() {
     i_nbDecimations = i_curDecimationId + 1;
     i_nbQuantizations = i_curQuantizationId;
 
+    // The level of detail index is put in front of the data once the LOD sizes are known.
+    dataBuffer.offset = 0;
+
     // Write the base mesh.
+    LodIndexEntry baseMeshEntry;
+    baseMeshEntry.i_offset = dataBuffer.offset;
+    baseMeshEntry.i_nbVertices = size_of_vertices();
+    baseMeshEntry.i_nbFaces = size_of_facets();
+    baseMeshEntry.i_operationType = BASE_MESH_OPERATION_ID;
+
     writeBaseMesh();
-    printf("Base mesh size: %lu bytes.\n", (size_t)ceil((connectivitySize + geometrySize) / 8.0));
+    printProgress("Base mesh size: %lu bytes.\n", (size_t)ceil((connectivitySize + geometrySize) / 8.0));
+
+    resetLodModels();
 
-    // Write the number of bytes needed to decode the base mesh.
-    osDebug << connectivitySize + geometrySize
-            /*<< "," << connectivitySize << "," << geometrySize*/
-            << std::endl;
+    baseMeshEntry.i_size = dataBuffer.offset - baseMeshEntry.i_offset;
+    baseMeshEntry.i_connectivitySize = connectivitySize;
+    baseMeshEntry.i_geometrySize = geometrySize;
+    lodIndex.push_back(baseMeshEntry);
 
-    printf("Writing the compressed data.\n");
+    printProgress("Writing the compressed data.\n");
 
     unsigned i_deci = i_curDecimationId;
     unsigned i_quant = i_curQuantizationId - 1;
@@ -47,6 +61,15 @@ void MyMesh::writeCompressedData() {
         unsigned i_curOperationType = typeOfOperation.back();
         typeOfOperation.pop_back();
 
+        LodIndexEntry entry;
+        entry.i_offset = dataBuffer.offset;
+        entry.i_nbVertices = lodMeshSizes.back().first;
+        entry.i_nbFaces = lodMeshSizes.back().second;
+        entry.i_operationType = i_curOperationType;
+        lodMeshSizes.pop_back();
+        size_t i_connectivitySizeBefore = connectivitySize;
+        size_t i_geometrySizeBefore = geometrySize;
+
         switch (i_curOperationType) {
             case DECIMATION_OPERATION_ID:
                 encodeRemovedVertices(i_deci);
@@ -59,112 +82,283 @@ void MyMesh::writeCompressedData() {
                 break;
             default: assert(0); break;
         }
-        // Write the number of bytes needed to decode the current LOD.
-        osDebug << connectivitySize + geometrySize /*<< ","
-                << connectivitySize << "," << geometrySize*/
-                << std::endl;
+
+        entry.i_size = dataBuffer.offset - entry.i_offset;
+        entry.i_connectivitySize = connectivitySize - i_connectivitySizeBefore;
+        entry.i_geometrySize = geometrySize - i_geometrySizeBefore;
+        lodIndex.push_back(entry);
     }
 
-    printf("Connectivity size: %lu bytes -> %.2f bits per vertex.\n", (size_t)ceil(connectivitySize / 8.0),
+    geometrySize += writeLodIndex() * 8;
+
+    printProgress("Connectivity size: %lu bytes -> %.2f bits per vertex.\n", (size_t)ceil(connectivitySize / 8.0),
            connectivitySize / (float)i_nbVerticesInit);
-    printf("Geometry size: %lu bytes -> %.2f bits per vertex.\n", (size_t)ceil(geometrySize / 8.0),
+    printProgress("Geometry size: %lu bytes -> %.2f bits per vertex.\n", (size_t)ceil(geometrySize / 8.0),
            geometrySize / (float)i_nbVerticesInit);
 
     size_t totalSize = connectivitySize + geometrySize;
-    printf("Total size: %lu bytes -> %.2f bits per vertex.\n", (size_t)ceil(totalSize / 8.0),
+    printProgress("Total size: %lu bytes -> %.2f bits per vertex.\n", (size_t)ceil(totalSize / 8.0),
            totalSize / (float)i_nbVerticesInit);
 
-    printf("Id of the first not convex decimation: %d.\n", i_levelNotConvexId);
+    printProgress("Id of the first not convex decimation: %d.\n", i_levelNotConvexId);
 }
 
 /**
  * Read the compressed data from the buffer.
- * \return the bounding box min position.
+ * \return false if the data is invalid.
  */
-void MyMesh::readCompressedData() {
+bool MyMesh::readCompressedData() {
+    // Read the level of detail index.
+    if (!readLodIndex()) {
+        if (!b_error)
+            stopOnError("The level of detail index is corrupted.");
+        return false;
+    }
+
+    if (!isLodAvailable(0)) {
+        stopOnError("The base mesh data is missing.");
+        return false;
+    }
+
     // Read the base mesh.
-    readBaseMesh();
+    dataBuffer.offset = lodIndex[0].i_offset;
+    if (!readBaseMesh())
+        return false;
+    resetLodModels();
+
+    if (lodIndex.size() != i_nbDecimations + i_nbQuantizations + 1) {
+        stopOnError("Wrong number of levels of detail in the index: %lu instead of %u.", lodIndex.size(),
+                    i_nbDecimations + i_nbQuantizations + 1);
+        return false;
+    }
+
+    printProgress("Bounding box min coordinates: %f %f %f.\n", bbMin.x(), bbMin.y(), bbMin.z());
+    printProgress("Quantization step: %f\n", f_quantStep);
 
-    printf("Bounding box min coordinates: %f %f %f.\n", bbMin.x(), bbMin.y(), bbMin.z());
-    printf("Quantization step: %f\n", f_quantStep);
+    return true;
 }
 
-// Write a given number of bits in a buffer.
-void writeBits(uint32_t data, unsigned i_nbBits, char* p_dest, unsigned& i_bitOffset, size_t& offset) {
-    assert(i_nbBits <= 25);
+/**
+ * Write the file header and the level of detail index and move them in front of the LOD data.
+ * Each entry is the LOD size in bytes and the vertex and face counts once the LOD is decoded;
+ * the LOD offsets follow from the sizes.
+ * \return the size of the header and the index in bytes.
+ */
+size_t MyMesh::writeLodIndex() {
+    size_t i_dataSize = dataBuffer.offset;
+
+    for (unsigned i = 0; i < FILE_MAGIC_SIZE; ++i)
+        dbputbyte(&dataBuffer, FILE_MAGIC[i]);
+    dbputbyte(&dataBuffer, FILE_FORMAT_VERSION);
+
+    writeVarUInt64(lodIndex.size());
+    for (unsigned i = 0; i < lodIndex.size(); ++i) {
+        const LodIndexEntry& entry = lodIndex[i];
+        writeVarUInt64(entry.i_size);
+        writeVarUInt64(entry.i_nbVertices);
+        writeVarUInt64(entry.i_nbFaces);
+        writeVarUInt64(entry.i_operationType);
+        writeVarUInt64(entry.i_connectivitySize);
+        writeVarUInt64(entry.i_geometrySize);
+    }
+
+    size_t i_indexSize = dataBuffer.offset - i_dataSize;
+    std::rotate(dataBuffer.p_data, dataBuffer.p_data + i_dataSize, dataBuffer.p_data + dataBuffer.offset);
+    for (unsigned i = 0; i < lodIndex.size(); ++i)
+        lodIndex[i].i_offset += i_indexSize;
+
+    return i_indexSize;
+}
+
+/**
+ * Read the file header and the level of detail index at the beginning of the buffer.
+ * \return false if the index is not completely in the buffer yet or if it is invalid,
+ *         in which case the job is stopped.
+ */
+bool MyMesh::readLodIndex() {
+    dataBuffer.offset = 0;
+    lodIndex.clear();
+
+    if (dataBuffer.size < FILE_HEADER_SIZE)
+        return false;
+    if (memcmp(dataBuffer.p_data, FILE_MAGIC, FILE_MAGIC_SIZE) != 0) {
+        stopOnError("The data is not a PPMC compressed file.");
+        return false;
+    }
+    dataBuffer.offset = FILE_MAGIC_SIZE;
+
+    unsigned i_version = dbgetbyte(&dataBuffer);
+    if (i_version != FILE_FORMAT_VERSION) {
+        stopOnError("Unsupported compressed file format version: %u.", i_version);
+        return false;
+    }
+
+    uint64_t i_nbLods = readVarUInt64();
+    if (dataBuffer.offset > dataBuffer.size)
+        return false;
+    if (i_nbLods == 0) {
+        stopOnError("The level of detail index is corrupted.");
+        return false;
+    }
 
-    uint32_t dataToAdd = data << (32 - i_nbBits - i_bitOffset);
-    // Swap the integer bytes because the x86 architecture is little endian.
-    dataToAdd = __builtin_bswap32(dataToAdd);  // Call a GCC builtin function.
+    // Every entry takes at least six bytes, so a corrupted count stops at the end of the buffer.
+    // Half of the 64 bits range leaves room to add the index size to the offsets.
+    uint64_t i_offset = 0;
+    for (uint64_t i = 0; i < i_nbLods; ++i) {
+        LodIndexEntry entry;
+        entry.i_size = readVarUInt64();
+        uint64_t i_nbVertices = readVarUInt64();
+        uint64_t i_nbFaces = readVarUInt64();
+        uint64_t i_operationType = readVarUInt64();
+        entry.i_connectivitySize = readVarUInt64();
+        entry.i_geometrySize = readVarUInt64();
+        if (dataBuffer.offset > dataBuffer.size) {
+            lodIndex.clear();
+            return false;
+        }
+        // Only the first entry describes the base mesh.
+        bool b_validOperation = i == 0 ? i_operationType == BASE_MESH_OPERATION_ID
+                                       : i_operationType == DECIMATION_OPERATION_ID ||
+                                             i_operationType == QUANTIZATION_OPERATION_ID;
+        if (entry.i_size > UINT64_MAX / 2 - i_offset || i_nbVertices > UINT32_MAX || i_nbFaces > UINT32_MAX ||
+            !b_validOperation) {
+            stopOnError("The level of detail index is corrupted.");
+            return false;
+        }
+        entry.i_offset = i_offset;
+        entry.i_nbVertices = i_nbVertices;
+        entry.i_nbFaces = i_nbFaces;
+        entry.i_operationType = i_operationType;
+        i_offset += entry.i_size;
+        lodIndex.push_back(entry);
+    }
 
-    // Write the data.
-    *(uint32_t*)p_dest |= dataToAdd;
+    // The LOD data starts right after the index.
+    for (unsigned i = 0; i < lodIndex.size(); ++i)
+        lodIndex[i].i_offset += dataBuffer.offset;
 
-    // Update the size and offset.
-    offset += (i_bitOffset + i_nbBits) / 8;
-    i_bitOffset = (i_bitOffset + i_nbBits) % 8;
+    return true;
 }
 
 /**
- * Read a given number of bits in a buffer.
+ * Test if all the data of a level of detail is in the buffer.
  */
-uint32_t readBits(unsigned i_nbBits, char* p_src, unsigned& i_bitOffset, size_t& offset) {
-    assert(i_nbBits <= 25);
+bool MyMesh::isLodAvailable(unsigned i_lodId) const {
+    return i_lodId < lodIndex.size() &&
+           (size_t)lodIndex[i_lodId].i_offset + lodIndex[i_lodId].i_size <= dataBuffer.size;
+}
 
-    // Build the mask.
-    uint32_t mask = 0;
-    for (unsigned i = 0; i < 32 - i_bitOffset; ++i)
-        mask |= 1 << i;
-    // Swap the mask bytes because the x86 architecture is little endian.
-    mask = __builtin_bswap32(mask);  // Call a GCC builtin function.
+/**
+ * Append a chunk of the compressed data received from a stream.
+ * The base mesh is decoded as soon as its data has completely arrived.
+ * \return the number of levels of detail whose data is available.
+ */
+unsigned MyMesh::pushCompressedData(const char* p_data, size_t i_size) {
+    assert(i_mode != COMPRESSION_MODE_ID && (b_streaming || b_error));
+    if (b_error)
+        return 0;
+
+    unsigned i_nbAvailableLods = 0;
+    while (isLodAvailable(i_nbAvailableLods))
+        i_nbAvailableLods++;
+
+    appenddatabuffer(&dataBuffer, p_data, i_size);
+
+    if (lodIndex.empty()) {
+        // Wait until the index and the base mesh have completely arrived.
+        if (!readLodIndex())
+            return 0;
+        if (!isLodAvailable(0)) {
+            lodIndex.clear();
+            return 0;
+        }
 
-    uint32_t data = *(uint32_t*)p_src & mask;
+        beginDecompression();
+        if (b_error)
+            return 0;
+    }
 
-    // Swap the integer bytes because the x86 architecture is little endian.
-    data = __builtin_bswap32(data);  // Call a GCC builtin function.
+    for (; isLodAvailable(i_nbAvailableLods); ++i_nbAvailableLods)
+        printProgress("Level of detail %u available.\n", i_nbAvailableLods);
 
-    data >>= 32 - i_nbBits - i_bitOffset;
+    // All the data has been received.
+    if (i_nbAvailableLods == lodIndex.size())
+        b_streaming = false;
 
-    // Update the size and offset.
-    offset += (i_bitOffset + i_nbBits) / 8;
-    i_bitOffset = (i_bitOffset + i_nbBits) % 8;
+    return i_nbAvailableLods;
+}
 
-    return data;
+/**
+ * Signal that no more compressed data will be pushed.
+ * The decompression then stops at the last complete level of detail.
+ */
+void MyMesh::endCompressedData() {
+    b_streaming = false;
+
+    if (lodIndex.empty()) {
+        stopOnError("The base mesh data is missing.");
+    }
 }
 
 // Write a floating point number in the data buffer.
 void MyMesh::writeFloat(float f) {
-    *(float*)(p_data + dataOffset) = f;
-    dataOffset += sizeof(float);
+    for (unsigned i = 0; i < sizeof(float); ++i)
+        dbputbyte(&dataBuffer, ((unsigned char*)&f)[i]);
 }
 
 /**
  * Read a floating point number in the data buffer.
  */
 float MyMesh::readFloat() {
-    float f = *(float*)(p_data + dataOffset);
-    dataOffset += sizeof(float);
+    float f;
+    for (unsigned i = 0; i < sizeof(float); ++i)
+        ((unsigned char*)&f)[i] = dbgetbyte(&dataBuffer);
     return f;
 }
 
 // Write a 16 bits integer in the data buffer
 void MyMesh::writeInt16(int16_t i) {
-    *(int16_t*)(p_data + dataOffset) = i;
-    dataOffset += sizeof(int16_t);
+    for (unsigned j = 0; j < sizeof(int16_t); ++j)
+        dbputbyte(&dataBuffer, ((unsigned char*)&i)[j]);
 }
 
 /**
  * Read a 16 bits integer in the data buffer.
  */
 int16_t MyMesh::readInt16() {
-    int16_t i = *(int16_t*)(p_data + dataOffset);
-    dataOffset += sizeof(int16_t);
+    int16_t i;
+    for (unsigned j = 0; j < sizeof(int16_t); ++j)
+        ((unsigned char*)&i)[j] = dbgetbyte(&dataBuffer);
+    return i;
+}
+
+// Write a 64 bits unsigned integer in the data buffer with 7 bits per byte.
+void MyMesh::writeVarUInt64(uint64_t i) {
+    while (i >= 0x80) {
+        dbputbyte(&dataBuffer, (i & 0x7f) | 0x80);
+        i >>= 7;
+    }
+    dbputbyte(&dataBuffer, i);
+}
+
+/**
+ * Read a 64 bits unsigned integer written by writeVarUInt64() in the data buffer.
+ * At most ten bytes are read.
+ */
+uint64_t MyMesh::readVarUInt64() {
+    uint64_t i = 0;
+    for (unsigned i_shift = 0; i_shift < 64; i_shift += 7) {
+        unsigned char c = dbgetbyte(&dataBuffer);
+        i |= (uint64_t)(c & 0x7f) << i_shift;
+        if (!(c & 0x80))
+            break;
+    }
     return i;
 }
 
 // Write the base mesh.
 void MyMesh::writeBaseMesh() {
-    printf("Writing the base mesh.\n");
+    printProgress("Writing the base mesh.\n");
 
     // Write the bounding box min coordinate.
     for (unsigned i = 0; i < 3; ++i)
@@ -178,60 +372,60 @@ void MyMesh::writeBaseMesh() {
     unsigned i_nbFacesBaseMesh = size_of_facets();
     unsigned i_nbBitsPerVertex = ceil(log(i_nbVerticesBaseMesh) / log(2));
 
-    unsigned i_bitOffset = 0;
-    dataOffset++;
+    BitWriter bits(&dataBuffer);
 
     // Write the codec option status.
-    writeBits(b_useAdaptiveQuantization, 1, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    writeBits(b_useLiftingScheme, 1, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    writeBits(b_useCurvaturePrediction, 1, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    writeBits(b_useConnectivityPredictionFaces, 1, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    writeBits(b_useConnectivityPredictionEdges, 1, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    writeBits(b_useTriangleMeshConnectivityPredictionFaces, 1, p_data + dataOffset - 1, i_bitOffset, dataOffset);
+    bits.write(b_useAdaptiveQuantization, 1);
+    bits.write(b_useLiftingScheme, 1);
+    bits.write(b_useCurvaturePrediction, 1);
+    bits.write(b_useConnectivityPredictionFaces, 1);
+    bits.write(b_useConnectivityPredictionEdges, 1);
+    bits.write(b_useTriangleMeshConnectivityPredictionFaces, 1);
+    bits.write(b_useRans, 1);
+    bits.write(b_useWarmStart, 1);
     geometrySize += 3;
-    connectivitySize += 4;
+    connectivitySize += 6;
+
+    // Write the id of the model priors.
+    connectivitySize += bits.writeVarint(i_modelPriorsId);
 
     // Write the geometry quantization of the mesh.
     assert(i_quantBits - 1 < 1 << 4);
-    writeBits(i_quantBits - 1, 4, p_data + dataOffset - 1, i_bitOffset, dataOffset);
+    bits.write(i_quantBits - 1, 4);
     geometrySize += 4;
 
     // Write the number of level of decimations.
-    assert(i_nbDecimations < 1 << 6);
-    writeBits(i_nbDecimations, 6, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    connectivitySize += 6;
+    connectivitySize += bits.writeVarint(i_nbDecimations);
 
     // Write the number of adaptive quantizations.
-    assert(i_nbQuantizations < 1 << 6);
-    writeBits(i_nbQuantizations, 6, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    connectivitySize += 6;
+    connectivitySize += bits.writeVarint(i_nbQuantizations);
 
     // Write the number of non-convex level of details.
-    writeBits(i_nbDecimations - i_levelNotConvexId, 6, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    connectivitySize += 6;
+    connectivitySize += bits.writeVarint(i_nbDecimations - i_levelNotConvexId);
 
-    // Write the number of vertices and faces on 16 bits.
-    printf("Base mesh: %u vertices and %u faces.\n", i_nbVerticesBaseMesh, i_nbFacesBaseMesh);
-    writeBits(i_nbVerticesBaseMesh, 16, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    writeBits(i_nbFacesBaseMesh, 16, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    connectivitySize += 32;
+    // Write the number of vertices and faces.
+    printProgress("Base mesh: %u vertices and %u faces.\n", i_nbVerticesBaseMesh, i_nbFacesBaseMesh);
+    connectivitySize += bits.writeVarint(i_nbVerticesBaseMesh);
+    connectivitySize += bits.writeVarint(i_nbFacesBaseMesh);
 
     // Write the base mesh vertex coordinates.
     unsigned i_nbAdditionalBitsGeometry = b_useLiftingScheme ? LIFTING_NB_ADDITIONAL_BITS_GEOMETRY : 0;
 
+    // Id of each vertex in the base mesh, by vertex handle id.
+    std::vector<uint32_t> vertexIds(size_of_vertex_ids());
+
     // Write the vertices of the edge that is the departure of the coding conquests.
     for (unsigned j = 0; j < 2; ++j) {
         PointInt p = getQuantizedPos(vh_departureConquest[j]->point());
         for (unsigned i = 0; i < 3; ++i) {
             assert(p[i] < 1 << i_quantBits - i_curQuantizationId + i_nbAdditionalBitsGeometry);
-            writeBits(p[i], i_quantBits - i_curQuantizationId + i_nbAdditionalBitsGeometry, p_data + dataOffset - 1,
-                      i_bitOffset, dataOffset);
+            bits.write(p[i], i_quantBits - i_curQuantizationId + i_nbAdditionalBitsGeometry);
         }
-        vh_departureConquest[j]->setId(j);
+        vertexIds[vh_departureConquest[j]->id()] = j;
     }
 
     // Write the other vertices.
-    size_t id = 2;
+    uint32_t id = 2;
     for (MyMesh::Vertex_iterator vit = vertices_begin(); vit != vertices_end(); ++vit) {
         if (vit == vh_departureConquest[0] || vit == vh_departureConquest[1])
             continue;
@@ -241,11 +435,10 @@ void MyMesh::writeBaseMesh() {
         // Write the coordinates.
         for (unsigned i = 0; i < 3; ++i) {
             assert(p[i] < 1 << i_quantBits - i_curQuantizationId + i_nbAdditionalBitsGeometry);
-            writeBits(p[i], i_quantBits - i_curQuantizationId + i_nbAdditionalBitsGeometry, p_data + dataOffset - 1,
-                      i_bitOffset, dataOffset);
+            bits.write(p[i], i_quantBits - i_curQuantizationId + i_nbAdditionalBitsGeometry);
         }
         // Set an id to the vertex.
-        vit->setId(id++);
+        vertexIds[vit->id()] = id++;
     }
     geometrySize += i_nbVerticesBaseMesh * 3 * (i_quantBits - i_curQuantizationId);
 
@@ -253,25 +446,32 @@ void MyMesh::writeBaseMesh() {
     for (MyMesh::Facet_iterator fit = facets_begin(); fit != facets_end(); ++fit) {
         unsigned i_faceDegree = fit->facet_degree();
         unsigned i_code = i_faceDegree - 3;
-        assert(i_code < 1 << NB_BITS_FACE_DEGREE_BASE_MESH);
-        writeBits(i_code, NB_BITS_FACE_DEGREE_BASE_MESH, p_data + dataOffset - 1, i_bitOffset, dataOffset);
+        if (i_code < BASE_MESH_FACE_DEGREE_ESCAPE)
+            bits.write(i_code, NB_BITS_FACE_DEGREE_BASE_MESH);
+        else {
+            // Large degrees are followed by the rest of the degree.
+            bits.write(BASE_MESH_FACE_DEGREE_ESCAPE, NB_BITS_FACE_DEGREE_BASE_MESH);
+            connectivitySize += bits.writeVarint(i_code - BASE_MESH_FACE_DEGREE_ESCAPE);
+        }
 
         Halfedge_around_facet_const_circulator hit(fit->facet_begin()), end(hit);
         do {
             // Write the current vertex id.
-            writeBits(hit->vertex()->getId(), i_nbBitsPerVertex, p_data + dataOffset - 1, i_bitOffset, dataOffset);
+            bits.write(vertexIds[hit->vertex()->id()], i_nbBitsPerVertex);
         } while (++hit != end);
 
         connectivitySize += i_nbBitsPerVertex * i_faceDegree + NB_BITS_FACE_DEGREE_BASE_MESH;
     }
 
-    if (i_bitOffset == 0)
-        dataOffset--;
+    bits.flush();
 }
 
-// Read the base mesh.
-void MyMesh::readBaseMesh() {
-    printf("Reading the base mesh.\n");
+/**
+ * Read the base mesh.
+ * \return false if the data is invalid.
+ */
+bool MyMesh::readBaseMesh() {
+    printProgress("Reading the base mesh.\n");
 
     // Read the bounding box min coordinate.
     float coord[3];
@@ -282,90 +482,124 @@ void MyMesh::readBaseMesh() {
     // Read the quantization step.
     f_quantStep = readFloat();
 
-    unsigned i_bitOffset = 0;
-    dataOffset++;
+    BitReader bits(&dataBuffer);
 
     // Read the codec option status.
-    b_useAdaptiveQuantization = readBits(1, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    b_useLiftingScheme = readBits(1, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    b_useCurvaturePrediction = readBits(1, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    b_useConnectivityPredictionFaces = readBits(1, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    b_useConnectivityPredictionEdges = readBits(1, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    b_useTriangleMeshConnectivityPredictionFaces = readBits(1, p_data + dataOffset - 1, i_bitOffset, dataOffset);
+    b_useAdaptiveQuantization = bits.read(1);
+    b_useLiftingScheme = bits.read(1);
+    b_useCurvaturePrediction = bits.read(1);
+    b_useConnectivityPredictionFaces = bits.read(1);
+    b_useConnectivityPredictionEdges = bits.read(1);
+    b_useTriangleMeshConnectivityPredictionFaces = bits.read(1);
+    b_useRans = bits.read(1);
+    b_useWarmStart = bits.read(1);
+
+    // Read the id of the model priors.
+    i_modelPriorsId = bits.readVarint();
+    p_modelPriors = getModelPriors(i_modelPriorsId);
+    if (i_modelPriorsId != 0 && p_modelPriors == NULL) {
+        stopOnError("Unknown model priors id: %u.", i_modelPriorsId);
+        return false;
+    }
 
     // Read the geometry quantization of the mesh.
-    i_quantBits = readBits(4, p_data + dataOffset - 1, i_bitOffset, dataOffset) + 1;
+    i_quantBits = bits.read(4) + 1;
 
     // Read the number of level of detail.
-    i_nbDecimations = readBits(6, p_data + dataOffset - 1, i_bitOffset, dataOffset);
+    i_nbDecimations = bits.readVarint();
 
     // Read the number of quantization operations.
-    i_nbQuantizations = i_curQuantizationId = readBits(6, p_data + dataOffset - 1, i_bitOffset, dataOffset);
+    i_nbQuantizations = i_curQuantizationId = bits.readVarint();
 
     // Read the number of non convex level of details.
-    i_levelNotConvexId = readBits(6, p_data + dataOffset - 1, i_bitOffset, dataOffset);
+    i_levelNotConvexId = bits.readVarint();
 
     // Set the mesh bounding box.
     unsigned i_nbQuantStep = 1 << i_quantBits;
     bbMax = bbMin + Vector(i_nbQuantStep * f_quantStep, i_nbQuantStep * f_quantStep, i_nbQuantStep * f_quantStep);
 
-    unsigned i_nbVerticesBaseMesh = readBits(16, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    unsigned i_nbFacesBaseMesh = readBits(16, p_data + dataOffset - 1, i_bitOffset, dataOffset);
-    unsigned i_nbBitsPerVertex = ceil(log(i_nbVerticesBaseMesh) / log(2));
+    unsigned i_nbVerticesBaseMesh = bits.readVarint();
+    unsigned i_nbFacesBaseMesh = bits.readVarint();
 
-    std::deque<Point>* p_pointDeque = new std::deque<Point>();
-    std::deque<uint32_t*>* p_faceDeque = new std::deque<uint32_t*>();
+    // The coordinates keep at least one bit, and the element counts must fit in the base mesh data
+    // before the arrays are allocated.
     unsigned i_nbAdditionalBitsGeometry = b_useLiftingScheme ? LIFTING_NB_ADDITIONAL_BITS_GEOMETRY : 0;
+    if (i_nbQuantizations >= i_quantBits || i_nbVerticesBaseMesh == 0) {
+        stopOnError("The base mesh is corrupted.");
+        return false;
+    }
+    unsigned i_nbBitsPerCoord = i_quantBits - i_curQuantizationId + i_nbAdditionalBitsGeometry;
+    unsigned i_nbBitsPerVertex = ceil(log(i_nbVerticesBaseMesh) / log(2));
+    uint64_t i_minNbBits = (uint64_t)i_nbVerticesBaseMesh * 3 * i_nbBitsPerCoord +
+                           (uint64_t)i_nbFacesBaseMesh * (NB_BITS_FACE_DEGREE_BASE_MESH + 3 * i_nbBitsPerVertex);
+    if (i_minNbBits > (uint64_t)lodIndex[0].i_size * 8) {
+        stopOnError("The base mesh is corrupted.");
+        return false;
+    }
+
+    std::vector<float> vertices;
+    std::vector<uint32_t> faces;
+    vertices.reserve((size_t)i_nbVerticesBaseMesh * 3);
+    faces.reserve((size_t)i_nbFacesBaseMesh * 4);
 
     // Read the vertex positions.
     for (unsigned i = 0; i < i_nbVerticesBaseMesh; ++i) {
         uint32_t p[3];
         for (unsigned j = 0; j < 3; ++j)
-            p[j] = readBits(i_quantBits - i_curQuantizationId + i_nbAdditionalBitsGeometry, p_data + dataOffset - 1,
-                            i_bitOffset, dataOffset);
+            p[j] = bits.read(i_nbBitsPerCoord);
         PointInt posInt(p[0], p[1], p[2]);
         Point pos = getPos(posInt);
-        p_pointDeque->push_back(pos);
+        for (unsigned j = 0; j < 3; ++j)
+            vertices.push_back(pos[j]);
     }
 
     // Read the face vertex indices.
+    // A face visits a vertex at most once, and all the indices must fit in the base mesh data.
+    uint64_t i_nbIndexBits = 0;
     for (unsigned i = 0; i < i_nbFacesBaseMesh; ++i) {
-        uint32_t* f = new uint32_t[(1 << NB_BITS_FACE_DEGREE_BASE_MESH) + 3];
-
-        // Write in the first cell of the array the face degree.
-        f[0] = readBits(NB_BITS_FACE_DEGREE_BASE_MESH, p_data + dataOffset - 1, i_bitOffset, dataOffset) + 3;
-
-        for (unsigned j = 1; j < f[0] + 1; ++j)
-            f[j] = readBits(i_nbBitsPerVertex, p_data + dataOffset - 1, i_bitOffset, dataOffset);
+        // Write in the first cell the face degree.
+        unsigned i_code = bits.read(NB_BITS_FACE_DEGREE_BASE_MESH);
+        if (i_code == BASE_MESH_FACE_DEGREE_ESCAPE) {
+            uint32_t i_extraDegree = bits.readVarint();
+            if (i_nbVerticesBaseMesh < i_code + 3 || i_extraDegree > i_nbVerticesBaseMesh - 3 - i_code) {
+                stopOnError("The base mesh is corrupted.");
+                return false;
+            }
+            i_code += i_extraDegree;
+        }
+        i_nbIndexBits += (uint64_t)(i_code + 3) * i_nbBitsPerVertex;
+        if (i_nbIndexBits > (uint64_t)lodIndex[0].i_size * 8) {
+            stopOnError("The base mesh is corrupted.");
+            return false;
+        }
+        faces.push_back(i_code + 3);
 
-        p_faceDeque->push_back(f);
+        for (unsigned j = 0; j < i_code + 3; ++j)
+            faces.push_back(bits.read(i_nbBitsPerVertex));
     }
 
-    // Let the builder do its job.
-    MyMeshBaseBuilder<HalfedgeDS> builder(p_pointDeque, p_faceDeque);
-    delegate(builder);
+    bits.finish();
 
-    // Free the memory.
-    for (unsigned i = 0; i < p_faceDeque->size(); ++i)
-        delete[] p_faceDeque->at(i);
-    delete p_faceDeque;
-    delete p_pointDeque;
+    // The conquests walk the base mesh, so it must be a closed manifold one, like the compressed meshes.
+    if (!build(vertices, faces) || !is_closed() || !is_manifold()) {
+        stopOnError("The base mesh is corrupted.");
+        return false;
+    }
 
-    if (i_bitOffset == 0)
-        dataOffset--;
+    return true;
 }
 
 // Write the compressed data from the buffer to a file.
 int MyMesh::writeCompressedFile() const {
     int i_ret = 1;
 
-    std::cout << "Write the compressed file " << filePathOutput << "." << std::endl;
+    printProgress("Write the compressed file %s.\n", filePathOutput.c_str());
 
     std::filebuf fb;
     fb.open(filePathOutput.c_str(), std::ios::out | std::ios::trunc);
 
     if (fb.is_open()) {
-        if (fb.sputn(p_data, dataOffset) == (std::streamsize)dataOffset)
+        if (fb.sputn(dataBuffer.p_data, dataBuffer.offset) == (std::streamsize)dataBuffer.offset)
             i_ret = 0;
         fb.close();
     }
@@ -373,38 +607,75 @@ int MyMesh::writeCompressedFile() const {
     return i_ret;
 }
 
-// Read the compressed data from the file and store them in a buffer.
-int MyMesh::readCompressedFile(char psz_filePath[]) {
-    int i_ret = 1;
+/**
+ * Add the model symbol counts of the compression to the ones of the training file.
+ * \return 0 on success.
+ */
+int MyMesh::writeModelCountsFile() const {
+    const char* psz_filePath = modelCountsFilePath.c_str();
 
-    printf("Read the compressed file '%s'.\n", psz_filePath);
+    ModelCounts counts = ModelCounts();
+    if (std::ifstream(psz_filePath).good() && !readModelCounts(psz_filePath, counts))
+        return 1;
 
-    std::filebuf fb;
-    fb.open(psz_filePath, std::ios::in);
+    uint32_t* p_counts = (uint32_t*)&counts;
+    const uint32_t* p_newCounts = (const uint32_t*)p_modelCounts;
+    for (unsigned i = 0; i < sizeof(ModelCounts) / sizeof(uint32_t); ++i)
+        p_counts[i] += p_newCounts[i];
 
-    if (fb.is_open()) {
-        std::streamsize dataSize = fb.in_avail();
-        if (fb.sgetn(p_data, dataSize) == (std::streamsize)dataSize)
-            i_ret = 0;
-        fb.close();
-    }
+    printProgress("Write the model counts file %s.\n", psz_filePath);
+    return writeModelCounts(psz_filePath, counts) ? 0 : 1;
+}
 
-    return i_ret;
+// Map the compressed file in the data buffer.
+// The decoder reads the data directly from the mapping.
+int MyMesh::readCompressedFile(char psz_filePath[]) {
+    printProgress("Read the compressed file '%s'.\n", psz_filePath);
+
+    return mapdatabuffer(&dataBuffer, psz_filePath);
 }
 
-// Write the mesh in an off file.
-void MyMesh::writeMeshOff(const char psz_filePath[]) const {
-    std::filebuf fb;
-    fb.open(psz_filePath, std::ios::out | std::ios::trunc);
-    if (fb.is_open()) {
-        std::ostream os(&fb);
-        os << *this;
+// Write the mesh in a file whose format is given by its extension.
+void MyMesh::writeMesh(const char psz_filePath[]) {
+    // The arrays are kept to be reused by the next levels of detail.
+    getMesh(outputVertices, outputFaces);
+    if (!writeMeshFile(psz_filePath, outputVertices, outputFaces))
+        stopOnError("Can't write the mesh file '%s'.", psz_filePath);
+}
+
+/**
+ * Get the current mesh as vertex and face arrays.
+ * \param vertices the x, y and z coordinates of each vertex.
+ * \param faces for each face, its number of vertices followed by their ids.
+ */
+void MyMesh::getMesh(std::vector<float>& vertices, std::vector<uint32_t>& faces) {
+    vertices.clear();
+    vertices.reserve(size_of_vertices() * 3);
+    faces.clear();
+    faces.reserve(size_of_facets() * 4);
+
+    // Id of each vertex in the arrays, by vertex handle id.
+    std::vector<uint32_t> vertexIds(size_of_vertex_ids());
+    uint32_t id = 0;
+    for (MyMesh::Vertex_iterator vit = vertices_begin(); vit != vertices_end(); ++vit) {
+        vertexIds[vit->id()] = id++;
+        Point p = vit->point();
+        for (unsigned i = 0; i < 3; ++i)
+            vertices.push_back(p[i]);
+    }
+
+    for (MyMesh::Face_iterator fit = facets_begin(); fit != facets_end(); ++fit) {
+        faces.push_back(fit->facet_degree());
+        Halfedge_around_facet_circulator hit(fit->facet_begin()), end(hit);
+        do
+            faces.push_back(vertexIds[hit->vertex()->id()]);
+        while (++hit != end);
     }
 }
 
-void MyMesh::writeCurrentOperationMesh(std::string pathPrefix, unsigned i_id) const {
-    // Output the current mesh in an off file.
+void MyMesh::writeCurrentOperationMesh(std::string pathPrefix, unsigned i_id) {
+    // Output the current mesh in a file.
     std::ostringstream fileName;
-    fileName << pathPrefix << "_" << i_id << ".off";
-    writeMeshOff(fileName.str().c_str());
+    fileName << pathPrefix << "_" << i_id << outputMeshExtension;
+    writeMesh(fileName.str().c_str());
 }
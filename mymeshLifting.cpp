@@ -22,15 +22,15 @@
 
 /**
  * Lift the vertex positions.
+ * \return false if an unlifted position is out of the quantization grid, which only happens with corrupted data.
  */
-void MyMesh::lift(bool b_unlift) {
+bool MyMesh::lift(bool b_unlift) {
     if (b_unlift)
-        printf("Unlift.\n");
+        printProgress("Unlift.\n");
     else
-        printf("Lift.\n");
+        printProgress("Lift.\n");
 
-    for (MyMesh::Vertex_iterator vit = vertices_begin(); vit != vertices_end(); ++vit)
-        vit->resetState();
+    resetVertexStates();
 
     // Add the first halfedge to the queue.
     pushHehInit();
@@ -66,7 +66,7 @@ void MyMesh::lift(bool b_unlift) {
         do {
             Facet_handle f = hIt->facet();
             if (f->isSplittable())
-                lift = lift + f->getResidual();
+                lift = lift + residuals[f->id()];
             hIt = hIt->next()->opposite();
         } while (hIt != h);
 
@@ -77,10 +77,16 @@ void MyMesh::lift(bool b_unlift) {
 
         PointInt newPosInt = quantPos + lift / nNeighbours / INV_GAMMA;
 
-        for (unsigned i = 0; i < 3; ++i)
-            assert(newPosInt[i] >= 0 &&
-                   newPosInt[i] < 1 << (i_quantBits - i_curQuantizationId + LIFTING_NB_ADDITIONAL_BITS_GEOMETRY));
+        for (unsigned i = 0; i < 3; ++i) {
+            if (newPosInt[i] < 0 ||
+                newPosInt[i] >= 1 << (i_quantBits - i_curQuantizationId + LIFTING_NB_ADDITIONAL_BITS_GEOMETRY)) {
+                assert(b_unlift);
+                return false;
+            }
+        }
 
         vh->point() = getPos(newPosInt);
     }
+
+    return true;
 }
@@ -17,6 +17,8 @@
  * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
  *****************************************************************************/
 
+#include <algorithm>
+
 #include "mymesh.h"
 
 Vector MyMesh::computeNormal(Facet_const_handle f) const {
@@ -68,9 +70,9 @@ Vector MyMesh::computeNormal(Point p[3]) const {
 Vector MyMesh::computeVertexNormal(Halfedge_const_handle heh) const {
     MyMesh::Halfedge_around_vertex_const_circulator hit = heh->vertex_begin(), hit_end = hit;
     Vector n(CGAL::NULL_VECTOR);
-    CGAL_For_all(hit, hit_end) {
+    do
         n = n + computeNormal(hit->opposite());
-    }
+    while (++hit != hit_end);
     float f_sqLen = n.squared_length();
     return f_sqLen == 0 ? CGAL::NULL_VECTOR : n / sqrt(f_sqLen);
 }
@@ -115,10 +117,10 @@ unsigned MyMesh::vertexDegreeNotNew(Vertex_const_handle vh) const {
     unsigned i_degree = 0;
 
     Halfedge_around_vertex_const_circulator hit = vh->vertex_begin(), hit_end = hit;
-    CGAL_For_all(hit, hit_end) {
+    do {
         if (!hit->isNew())
             i_degree++;
-    }
+    } while (++hit != hit_end);
 
     return i_degree;
 }
@@ -182,9 +184,9 @@ float MyMesh::edgeLen(Halfedge_const_handle heh) const {
 float MyMesh::facePerimeter(const Face_handle fh) const {
     float f_ret = 0;
     Halfedge_around_facet_const_circulator hit = fh->facet_begin(), hit_end = hit;
-    CGAL_For_all(hit, hit_end) {
+    do
         f_ret += edgeLen(hit);
-    }
+    while (++hit != hit_end);
     return f_ret;
 }
 
@@ -223,19 +225,20 @@ float MyMesh::faceSurface(Halfedge_handle heh) const {
 
 /**
  * Push the first halfedge for the coding and decoding conquest in the gate queue.
+ * \return false if the departure vertices are not adjacent, which only happens with corrupted data.
  */
-void MyMesh::pushHehInit() {
+bool MyMesh::pushHehInit() {
     // Find the first halfedge.
-    Halfedge_handle hehBegin;
-    Halfedge_around_vertex_circulator hit(vh_departureConquest[0]->vertex_begin());
-    while (1) {
-        hehBegin = hit->opposite();
-        if (hehBegin->vertex() == vh_departureConquest[1])
-            break;
-        ++hit;
-    }
-    // Push it to the queue.
-    gateQueue.push(hehBegin);
+    Halfedge_around_vertex_circulator hit(vh_departureConquest[0]->vertex_begin()), hitEnd = hit;
+    do {
+        Halfedge_handle hehBegin = hit->opposite();
+        if (hehBegin->vertex() == vh_departureConquest[1]) {
+            // Push it to the queue.
+            gateQueue.push(hehBegin);
+            return true;
+        }
+    } while (++hit != hitEnd);
+    return false;
 }
 
 /**
@@ -269,3 +272,206 @@ void MyMesh::updateAvgEdgeLen(bool b_original, float f_edgeLen) {
         f_avgInsertedEdgesLength = (f_avgInsertedEdgesLength * (i_nbInsertedEdges - 1) + f_edgeLen) / i_nbInsertedEdges;
     }
 }
+
+/**
+ * Reset the models to their priors, before the first level of detail.
+ */
+void MyMesh::resetLodModels() {
+    for (unsigned i = 0; i < NB_RESIDUAL_CONTEXTS; ++i) {
+        resetqsmodel(&alphaBetaModels[i], p_modelPriors ? p_modelPriors->alphaBeta : NULL);
+#ifdef USE_BIJECTION
+        resetqsmodel(&gammaModels[i], p_modelPriors ? p_modelPriors->gamma : NULL);
+#endif
+    }
+    resetqsmodel(&quantModel, p_modelPriors ? p_modelPriors->quant : NULL);
+    resetBinModels(faceConnectModels, NB_FACE_CONNECT_CONTEXTS, p_modelPriors ? p_modelPriors->faceConnect : NULL);
+    resetBinModels(edgeConnectModels, NB_EDGE_CONNECT_CONTEXTS, p_modelPriors ? p_modelPriors->edgeConnect : NULL);
+}
+
+/**
+ * Determine the initial frequencies of an adaptive model for a new level of detail.
+ * With warm start, they are the current frequencies of the model, else its priors.
+ * \param p_freqs array of at least p_model->n values to store the frequencies of the model.
+ * \return the frequencies to reset the model with, NULL for a uniform model.
+ */
+const int* MyMesh::lodStartFreqs(const qsmodel* p_model, const int* p_priors, int* p_freqs) const {
+    if (!b_useWarmStart)
+        return p_priors;
+
+    for (int i = 0; i < p_model->n; ++i)
+        p_freqs[i] = p_model->cf[i + 1] - p_model->cf[i];
+    return p_freqs;
+}
+
+// Restart an adaptive model for a new level of detail.
+void MyMesh::restartModel(qsmodel* p_model, const int* p_priors) {
+    int startFreqs[RESIDUAL_NB_CLASSES];
+    resetqsmodel(p_model, lodStartFreqs(p_model, p_priors, startFreqs));
+}
+
+// Restart binary models for a new level of detail. With warm start, they keep their state.
+void MyMesh::restartBinModels(binmodel* p_models, unsigned i_nbModels, const binmodel* p_priors) {
+    if (!b_useWarmStart)
+        resetBinModels(p_models, i_nbModels, p_priors);
+}
+
+/**
+ * Determine the context of a face split symbol.
+ * It combines the face degree with the prediction of the connectivity prediction scheme:
+ * the split balance of the conquered neighbor faces for the triangle meshes or the closest
+ * average surface otherwise, and if the prediction is a strong one.
+ */
+unsigned MyMesh::faceSplitContext(Halfedge_handle h, float f_faceSurface) const {
+    unsigned i_degreeClass = std::min(h->facet_degree(), (size_t)5) - 3;
+
+    if (!b_useConnectivityPredictionFaces)
+        return i_degreeClass * NB_FACE_PREDICTION_CONTEXTS;
+
+    unsigned i_predictor;
+    bool b_predictedSplit, b_strong;
+
+    float f_nbConqueredFaces = i_nbFacesWithCenterRemoved + i_nbFacesWithoutCenterRemoved;
+    if (b_useTriangleMeshConnectivityPredictionFaces && f_nbConqueredFaces != 0 &&
+        fabs(i_nbFacesWithCenterRemoved / f_nbConqueredFaces - i_nbFacesWithoutCenterRemoved / f_nbConqueredFaces) < 0.1) {
+        // Triangle mesh connectivity prediction in the case the average area are similar.
+        // Balance number between the splittable and non splittable neighbor faces.
+        int i_neighborBalance = 0;
+
+        Halfedge_around_facet_const_circulator hit = h->facet_begin(), hit_end = hit;
+        do {
+            Face_const_handle fh = hit->opposite()->facet();
+
+            // Only the neighbor faces already conquered can be taken into account.
+            if (i_mode == COMPRESSION_MODE_ID ? fh->isProcessed() : fh->isConquered()) {
+                if (fh->isSplittable())
+                    i_neighborBalance++;
+                else if (fh->isUnsplittable())
+                    i_neighborBalance--;
+            }
+        } while (++hit != hit_end);
+
+        i_predictor = 0;
+        b_predictedSplit = i_neighborBalance < 0;
+        b_strong = abs(i_neighborBalance) >= 2;
+    }
+    else {
+        // Prediction from the closest average surface of the faces with and without a center vertex removed.
+        float f_distWith = fabs(f_faceSurface - f_avgSurfaceFaceWithCenterRemoved);
+        float f_distWithout = fabs(f_faceSurface - f_avgSurfaceFaceWithoutCenterRemoved);
+
+        i_predictor = 1;
+        b_predictedSplit =
+            (f_avgSurfaceFaceWithCenterRemoved != 0 && f_distWith <= f_distWithout) || f_avgSurfaceFaceWithoutCenterRemoved == 0;
+        b_strong = f_avgSurfaceFaceWithCenterRemoved != 0 && f_avgSurfaceFaceWithoutCenterRemoved != 0 &&
+                   (b_predictedSplit ? 2 * f_distWith <= f_distWithout : 2 * f_distWithout <= f_distWith);
+    }
+
+    return i_degreeClass * NB_FACE_PREDICTION_CONTEXTS + 1 + (i_predictor * 2 + b_predictedSplit) * 2 + b_strong;
+}
+
+/**
+ * Determine the context of an inserted edge symbol.
+ * It combines the number of splittable faces of the edge with the prediction
+ * from the closest average length of the original and inserted edges.
+ */
+unsigned MyMesh::insertedEdgeContext(Halfedge_handle h, float f_edgeLen) const {
+    unsigned i_nbSplittableFacesClass = h->facet()->isSplittable() && h->opposite()->facet()->isSplittable();
+
+    if (!b_useConnectivityPredictionEdges)
+        return i_nbSplittableFacesClass * NB_EDGE_PREDICTION_CONTEXTS;
+
+    float f_distOriginal = fabs(f_edgeLen - f_avgOriginalEdgesLength);
+    float f_distInserted = fabs(f_edgeLen - f_avgInsertedEdgesLength);
+
+    bool b_predictedOriginal =
+        (f_avgOriginalEdgesLength != 0 && f_distOriginal <= f_distInserted) || f_avgInsertedEdgesLength == 0;
+    bool b_strong = f_avgOriginalEdgesLength != 0 && f_avgInsertedEdgesLength != 0 &&
+                    (b_predictedOriginal ? 2 * f_distOriginal <= f_distInserted : 2 * f_distInserted <= f_distOriginal);
+
+    return i_nbSplittableFacesClass * NB_EDGE_PREDICTION_CONTEXTS + 1 + b_predictedOriginal * 2 + b_strong;
+}
+
+/**
+ * Determine the context of the residual of a split face, and add its curvature to the average.
+ * It combines the curvature magnitude, from the average laplacian vector of the face and
+ * relative to the average of the conquest, with the face degree.
+ */
+unsigned MyMesh::residualContext(Halfedge_handle h, const VectorInt& laplacian) {
+    uint64_t i_curvature = std::abs(laplacian.x()) + std::abs(laplacian.y()) + std::abs(laplacian.z());
+    i_sumCurvatures += i_curvature;
+    i_nbCurvatures++;
+
+    // Integer comparisons to the average, so that the contexts do not depend on the floating point rounding.
+    unsigned i_curvatureClass;
+    if (2 * i_curvature * i_nbCurvatures < i_sumCurvatures)
+        i_curvatureClass = 0;
+    else if (i_curvature * i_nbCurvatures < 2 * i_sumCurvatures)
+        i_curvatureClass = 1;
+    else
+        i_curvatureClass = 2;
+
+    unsigned i_degreeClass = h->facet_degree() > 5;
+
+    return i_curvatureClass * 2 + i_degreeClass;
+}
+
+/**
+ * Reset the conquered flag of all the vertices by starting a new generation.
+ */
+void MyMesh::resetVertexStates() {
+    if (++meshData.i_vertexGeneration == 0) {
+        // The generation counter wrapped around: clear the generations of the vertices.
+        for (Vertex_iterator vit = vertices_begin(); vit != vertices_end(); ++vit)
+            vit->data().i_conqueredGeneration = 0;
+        meshData.i_vertexGeneration = 1;
+    }
+}
+
+/**
+ * Reset the flags of all the halfedges by starting a new generation.
+ */
+void MyMesh::resetHalfedgeStates() {
+    if (++meshData.i_halfedgeGeneration == 0) {
+        for (Halfedge_iterator hit = halfedges_begin(); hit != halfedges_end(); ++hit)
+            hit->data().i_generation = 0;
+        meshData.i_halfedgeGeneration = 1;
+    }
+}
+
+/**
+ * Reset the flags of all the faces, the processed flag included, by starting new generations.
+ */
+void MyMesh::resetFaceStates() {
+    if (++meshData.i_faceGeneration == 0) {
+        for (Facet_iterator fit = facets_begin(); fit != facets_end(); ++fit)
+            fit->data().i_generation = 0;
+        meshData.i_faceGeneration = 1;
+    }
+    resetFaceProcessedFlags();
+}
+
+/**
+ * Reset the processed flag of all the faces by starting a new generation.
+ */
+void MyMesh::resetFaceProcessedFlags() {
+    if (++meshData.i_faceProcessedGeneration == 0) {
+        for (Facet_iterator fit = facets_begin(); fit != facets_end(); ++fit)
+            fit->data().i_processedGeneration = 0;
+        meshData.i_faceProcessedGeneration = 1;
+    }
+}
+
+/**
+ * Drop the removed elements from the mesh arrays when they take too much of them.
+ * The ids change, so it is only done between two operations.
+ */
+void MyMesh::compactElements() {
+    if (removed_fraction() < COMPACTION_MIN_REMOVED_FRACTION)
+        return;
+
+    std::vector<uint32_t> newVertexIds;
+    compact(newVertexIds);
+
+    for (unsigned i = 0; i < 2; ++i)
+        vh_departureConquest[i] = Vertex_handle(this, newVertexIds[vh_departureConquest[i]->id()]);
+}
@@ -0,0 +1,122 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "ppmc.h"
+#include "configuration.h"
+#include "mymesh.h"
+
+// Report the reason of a failure to the caller, if it asked for it.
+static void setErrorMessage(std::string* p_errorMessage, const std::string& message) {
+    if (p_errorMessage != NULL)
+        *p_errorMessage = message;
+}
+
+bool ppmcCompress(const std::vector<float>& vertices,
+                  const std::vector<uint32_t>& faces,
+                  const PPMCOptions& options,
+                  std::vector<char>& compressedData,
+                  std::string* p_errorMessage) {
+    // An empty output path keeps the compressed data in memory.
+    MyMesh mesh(NULL, "", 100, COMPRESSION_MODE_ID, options.i_quantBits, options.b_useAdaptiveQuantization,
+                options.b_useLiftingScheme, options.b_useCurvaturePrediction, options.b_useConnectivityPredictionFaces,
+                options.b_useConnectivityPredictionEdges, options.b_allowConcaveFaces,
+                options.b_useTriangleMeshConnectivityPredictionFaces, options.b_useRans,
+                options.b_useStaticTables, options.i_modelPriorsId, options.b_useWarmStart, false);
+
+    if (mesh.hasError() || !mesh.loadMesh(vertices, faces)) {
+        setErrorMessage(p_errorMessage, mesh.getErrorMessage());
+        return false;
+    }
+
+    mesh.completeOperation();
+
+    if (mesh.hasError()) {
+        setErrorMessage(p_errorMessage, mesh.getErrorMessage());
+        return false;
+    }
+
+    const databuffer* p_buffer = mesh.getCompressedData();
+    compressedData.assign(p_buffer->p_data, p_buffer->p_data + p_buffer->size);
+
+    return true;
+}
+
+int ppmcDecompress(const char* p_data,
+                   size_t i_size,
+                   int i_lodId,
+                   std::vector<float>& vertices,
+                   std::vector<uint32_t>& faces,
+                   std::string* p_errorMessage) {
+    // The codec options are read from the compressed data.
+    MyMesh mesh(NULL, "", 100, DECOMPRESSION_MODE_ID, 0, false, false, false, false, false, false, false, false, false, 0,
+                false, false);
+
+    mesh.pushCompressedData(p_data, i_size);
+    mesh.endCompressedData();
+
+    if (mesh.isJobCompleted()) {
+        setErrorMessage(p_errorMessage,
+                        mesh.hasError() ? mesh.getErrorMessage() : "The data does not contain the base mesh.");
+        return -1;
+    }
+
+    while (!mesh.isJobCompleted() && (i_lodId < 0 || mesh.getCurrentLodId() < (unsigned)i_lodId))
+        mesh.batchOperation();
+
+    if (mesh.hasError()) {
+        setErrorMessage(p_errorMessage, mesh.getErrorMessage());
+        return -1;
+    }
+
+    mesh.getMesh(vertices, faces);
+
+    return mesh.getCurrentLodId();
+}
+
+bool ppmcReadLodIndex(const char* p_data,
+                      size_t i_size,
+                      std::vector<PPMCLodInfo>& lods,
+                      std::string* p_errorMessage) {
+    MyMesh mesh(NULL, "", 100, DECOMPRESSION_MODE_ID, 0, false, false, false, false, false, false, false, false, false, 0,
+                false, false);
+
+    // The index is kept once the base mesh data has arrived, so the data must at least hold it.
+    mesh.pushCompressedData(p_data, i_size);
+    if (mesh.hasError() || mesh.getLodIndex().empty()) {
+        setErrorMessage(p_errorMessage,
+                        mesh.hasError() ? mesh.getErrorMessage() : "The data does not contain the base mesh.");
+        return false;
+    }
+
+    const std::vector<LodIndexEntry>& lodIndex = mesh.getLodIndex();
+    lods.resize(lodIndex.size());
+    for (unsigned i = 0; i < lodIndex.size(); ++i) {
+        const LodIndexEntry& entry = lodIndex[i];
+        PPMCLodInfo& lod = lods[i];
+        lod.i_offset = entry.i_offset;
+        lod.i_size = entry.i_size;
+        lod.i_operationType = entry.i_operationType;
+        lod.i_nbVertices = entry.i_nbVertices;
+        lod.i_nbFaces = entry.i_nbFaces;
+        lod.i_connectivitySize = entry.i_connectivitySize;
+        lod.i_geometrySize = entry.i_geometrySize;
+    }
+
+    return true;
+}
@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef PPMC_H
+#define PPMC_H
+
+/*
+  In-memory interface of the PPMC codec.
+
+  A mesh is described by two arrays:
+  - vertices holds the x, y and z coordinates of each vertex;
+  - faces holds, for each face, its number of vertices followed by
+    their ids, as in the OFF format.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Codec options. The default values are the ones of the command line tool.
+struct PPMCOptions {
+    unsigned i_quantBits;
+    bool b_useAdaptiveQuantization;
+    bool b_useLiftingScheme;
+    bool b_useCurvaturePrediction;
+    bool b_useConnectivityPredictionFaces;
+    bool b_useConnectivityPredictionEdges;
+    bool b_allowConcaveFaces;
+    bool b_useTriangleMeshConnectivityPredictionFaces;
+    bool b_useRans;  // rANS entropy coding, faster to decode than the range coder.
+    bool b_useStaticTables;  // Static residual models where they are smaller, faster to decode.
+    unsigned i_modelPriorsId;  // Id of the trained model priors, 0 for uniform models. 1 is the default set.
+    bool b_useWarmStart;  // Models of each level of detail started from the ones of the previous level.
+
+    PPMCOptions()
+        : i_quantBits(12), b_useAdaptiveQuantization(false), b_useLiftingScheme(true), b_useCurvaturePrediction(true),
+          b_useConnectivityPredictionFaces(true), b_useConnectivityPredictionEdges(true), b_allowConcaveFaces(true),
+          b_useTriangleMeshConnectivityPredictionFaces(true), b_useRans(false), b_useStaticTables(false),
+          i_modelPriorsId(1), b_useWarmStart(false) {}
+};
+
+/**
+ * Compress a mesh.
+ * \param p_errorMessage if not NULL, receives the reason of a failure.
+ * \return false if the codec can not handle the mesh or the options are invalid.
+ */
+bool ppmcCompress(const std::vector<float>& vertices,
+                  const std::vector<uint32_t>& faces,
+                  const PPMCOptions& options,
+                  std::vector<char>& compressedData,
+                  std::string* p_errorMessage = NULL);
+
+/**
+ * Decompress a mesh up to a given level of detail.
+ * The levels of detail that are not convex are always decoded.
+ * \param i_lodId the level of detail to reach, 0 being the base mesh. A negative value decodes all of them.
+ * \param p_errorMessage if not NULL, receives the reason of a failure.
+ * \return the id of the decoded level of detail or -1 if the data is invalid or does not contain the base mesh.
+ */
+int ppmcDecompress(const char* p_data,
+                   size_t i_size,
+                   int i_lodId,
+                   std::vector<float>& vertices,
+                   std::vector<uint32_t>& faces,
+                   std::string* p_errorMessage = NULL);
+
+// Entry of the level of detail index of a compressed file.
+struct PPMCLodInfo {
+    uint64_t i_offset;            // Offset of the LOD data from the beginning of the file.
+    uint64_t i_size;              // Size of the LOD data in bytes.
+    unsigned i_operationType;     // 0 for a decimation, 1 for an adaptive quantization, 2 for the base mesh.
+    uint32_t i_nbVertices;        // Number of vertices once the LOD is decoded.
+    uint32_t i_nbFaces;           // Number of faces once the LOD is decoded.
+    uint64_t i_connectivitySize;  // Size of the LOD connectivity in bits.
+    uint64_t i_geometrySize;      // Size of the LOD geometry in bits.
+};
+
+/**
+ * Read the level of detail index of a compressed file, the base mesh first.
+ * \param p_errorMessage if not NULL, receives the reason of a failure.
+ * \return false if the data is invalid or does not contain the index and the base mesh.
+ */
+bool ppmcReadLodIndex(const char* p_data,
+                      size_t i_size,
+                      std::vector<PPMCLodInfo>& lods,
+                      std::string* p_errorMessage = NULL);
+
+#endif  // PPMC_H
@@ -0,0 +1,70 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef BINMODEL_H
+#define BINMODEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  binmodel.h     adaptive binary probability model
+
+  The model keeps the frequency of the 0 on a total of 1<<BINMODEL_LG_TOTF
+  and moves it toward each coded bit by 1/(1<<BINMODEL_ADAPT_SHIFT) of the
+  distance, so coding and updating need no division. The frequencies stay
+  in [1<<BINMODEL_ADAPT_SHIFT - 1, (1<<BINMODEL_LG_TOTF) - (1<<BINMODEL_ADAPT_SHIFT) + 1]:
+  both bits can always be coded.
+
+  The frequencies are given to the coders with encode_shift() and
+  decode_bit_shift(), or their rANS counterparts.
+*/
+
+#include "port.h"
+
+#define BINMODEL_LG_TOTF 12
+#define BINMODEL_ADAPT_SHIFT 4
+
+typedef uint2 binmodel;  /* frequency of the 0 */
+
+/* initialisation with equiprobable bits */
+static Inline void initbinmodel(binmodel *m) {
+    *m = 1 << (BINMODEL_LG_TOTF - 1);
+}
+
+/* frequency of a bit and of the smaller bits */
+static Inline void binmodelgetfreq(const binmodel *m, int bit, int *sy_f, int *lt_f) {
+    *sy_f = bit ? (1 << BINMODEL_LG_TOTF) - *m : *m;
+    *lt_f = bit ? *m : 0;
+}
+
+/* update the model with the coded bit */
+static Inline void binmodelupdate(binmodel *m, int bit) {
+    if (bit)
+        *m -= *m >> BINMODEL_ADAPT_SHIFT;
+    else
+        *m += ((1 << BINMODEL_LG_TOTF) - *m) >> BINMODEL_ADAPT_SHIFT;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,147 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "databuffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define DATABUFFER_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+void initdatabuffer(databuffer* b) {
+    b->p_data = NULL;
+    b->offset = 0;
+    b->size = 0;
+    b->capacity = 0;
+    b->b_mapped = 0;
+}
+
+void deletedatabuffer(databuffer* b) {
+#ifdef DATABUFFER_USE_MMAP
+    if (b->b_mapped)
+        munmap(b->p_data, b->size);
+    else
+#endif
+        free(b->p_data);
+    initdatabuffer(b);
+}
+
+// Read the whole file in the heap.
+static int readdatabuffer(databuffer* b, const char* psz_filePath) {
+    FILE* p_file;
+    long i_fileSize;
+    int i_ret = 1;
+
+    p_file = fopen(psz_filePath, "rb");
+    if (p_file == NULL)
+        return 1;
+
+    if (fseek(p_file, 0, SEEK_END) == 0 && (i_fileSize = ftell(p_file)) >= 0 && fseek(p_file, 0, SEEK_SET) == 0) {
+        reservedatabuffer(b, i_fileSize);
+        if (fread(b->p_data, 1, i_fileSize, p_file) == (size_t)i_fileSize) {
+            b->size = i_fileSize;
+            i_ret = 0;
+        }
+    }
+
+    fclose(p_file);
+    return i_ret;
+}
+
+int mapdatabuffer(databuffer* b, const char* psz_filePath) {
+#ifdef DATABUFFER_USE_MMAP
+    int fd;
+    struct stat st;
+    void* p_map;
+
+    fd = open(psz_filePath, O_RDONLY);
+    if (fd < 0)
+        return 1;
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        p_map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p_map != MAP_FAILED) {
+            close(fd);
+            b->p_data = (char*)p_map;
+            b->offset = 0;
+            b->size = st.st_size;
+            b->capacity = 0;
+            b->b_mapped = 1;
+            return 0;
+        }
+    }
+    close(fd);
+#endif
+
+    return readdatabuffer(b, psz_filePath);
+}
+
+void reservedatabuffer(databuffer* b, size_t i_capacity) {
+    size_t i_newCapacity;
+    char* p_newData;
+
+    if (i_capacity <= b->capacity)
+        return;
+
+    // Grow geometrically to keep the amortized cost of a write constant.
+    i_newCapacity = b->capacity ? b->capacity : DATABUFFER_INITIAL_CAPACITY;
+    while (i_newCapacity < i_capacity || i_newCapacity < b->size)
+        i_newCapacity *= 2;
+
+    if (b->b_mapped) {
+        // Copy the mapped data before the first write.
+        p_newData = (char*)malloc(i_newCapacity);
+        if (p_newData != NULL) {
+            memcpy(p_newData, b->p_data, b->size);
+            b->capacity = b->size;
+#ifdef DATABUFFER_USE_MMAP
+            munmap(b->p_data, b->size);
+#endif
+            b->b_mapped = 0;
+        }
+    }
+    else
+        p_newData = (char*)realloc(b->p_data, i_newCapacity);
+
+    if (p_newData == NULL) {
+        fprintf(stderr, "Can't allocate %lu bytes for the compressed data.\n", (unsigned long)i_newCapacity);
+        exit(EXIT_FAILURE);
+    }
+
+    // Only the new part is cleared.
+    memset(p_newData + b->capacity, 0, i_newCapacity - b->capacity);
+
+    b->p_data = p_newData;
+    b->capacity = i_newCapacity;
+}
+
+void appenddatabuffer(databuffer* b, const char* p_data, size_t i_size) {
+    if (i_size == 0)
+        return;
+    reservedatabuffer(b, b->size + i_size);
+    memcpy(b->p_data + b->size, p_data, i_size);
+    b->size += i_size;
+}
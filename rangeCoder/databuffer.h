@@ -0,0 +1,100 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef DATABUFFER_H
+#define DATABUFFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  databuffer.h     growable byte buffer for the compressed data
+
+  The buffer is the byte sink of the encoder and the byte source of the
+  decoder. Memory is only allocated when the first byte is written and
+  the buffer then grows geometrically, so small meshes do not pay for a
+  large up-front allocation. Bytes between the end of the written data
+  and the capacity are always zero, so an area that is reserved and
+  written later is deterministic.
+
+  Reading past the end of the valid data returns 0 instead of touching
+  memory that does not belong to the buffer.
+
+  A buffer can also be a read-only mapping of a compressed file. Such a
+  buffer has no writable capacity: the first write copies the mapped data
+  to the heap.
+*/
+
+#include <stddef.h>
+
+#include "port.h"
+
+/* capacity of the first allocation */
+#define DATABUFFER_INITIAL_CAPACITY 4096
+
+typedef struct {
+    char* p_data;     /* the bytes, NULL until the first allocation */
+    size_t offset;    /* the offset to read and write */
+    size_t size;      /* number of valid bytes */
+    size_t capacity;  /* number of writable bytes */
+    int b_mapped;     /* 1 if p_data is a read-only file mapping */
+} databuffer;
+
+/* initialisation of an empty buffer; does not allocate */
+void initdatabuffer(databuffer* b);
+
+/* deletion of the buffer memory */
+void deletedatabuffer(databuffer* b);
+
+/* map the file psz_filePath read-only in an empty buffer   */
+/* the file is read in memory if it can not be mapped      */
+/* returns 0 on success                                    */
+int mapdatabuffer(databuffer* b, const char* psz_filePath);
+
+/* make sure that at least i_capacity bytes are allocated */
+/* the new bytes are set to 0                              */
+void reservedatabuffer(databuffer* b, size_t i_capacity);
+
+/* append i_size bytes after the valid data            */
+/* the offset is not modified                            */
+void appenddatabuffer(databuffer* b, const char* p_data, size_t i_size);
+
+/* write a byte at the current offset and move forward */
+static Inline void dbputbyte(databuffer* b, unsigned char c) {
+    if (b->offset >= b->capacity)
+        reservedatabuffer(b, b->offset + 1);
+    b->p_data[b->offset++] = c;
+    if (b->offset > b->size)
+        b->size = b->offset;
+}
+
+/* read the byte at the current offset and move forward */
+/* returns 0 past the end of the valid data             */
+static Inline unsigned char dbgetbyte(databuffer* b) {
+    unsigned char c = b->offset < b->size ? b->p_data[b->offset] : 0;
+    b->offset++;
+    return c;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
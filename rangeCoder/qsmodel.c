@@ -98,7 +98,7 @@ static void dorescale( qsmodel *m)
 /* rescale  desired rescaling interval, should be < 1<<(lg_totf+1) */
 /* init  array of int's to be used for initialisation (NULL ok) */
 /* compress  set to 1 on compression, 0 on decompression */
-void initqsmodel( qsmodel *m, int n, int lg_totf, int rescale, int *init, int compress )
+void initqsmodel( qsmodel *m, int n, int lg_totf, int rescale, const int *init, int compress )
 {   m->n = n;
     m->targetrescale = rescale;
     m->searchshift = lg_totf - TBLSHIFT;
@@ -121,7 +121,7 @@ void initqsmodel( qsmodel *m, int n, int lg_totf, int rescale, int *init, int co
 /* reinitialisation of qsmodel                         */
 /* m   qsmodel to be initialized                       */
 /* init  array of int's to be used for initialisation (NULL ok) */
-void resetqsmodel( qsmodel *m, int *init)
+void resetqsmodel( qsmodel *m, const int *init)
 {   int i, end, initval;
     m->rescale = m->n>>4 | 2;
     m->nextleft = 0;
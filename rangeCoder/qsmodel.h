@@ -65,12 +65,12 @@ typedef struct {
 /* init  array of int's to be used for initialisation (NULL ok) */
 /* compress  set to 1 on compression, 0 on decompression */
 void initqsmodel( qsmodel *m, int n, int lg_totf, int rescale,
-   int *init, int compress );
+   const int *init, int compress );
 
 /* reinitialisation of qsmodel                         */
 /* m   qsmodel to be initialized                       */
 /* init  array of int's to be used for initialisation (NULL ok) */
-void resetqsmodel( qsmodel *m, int *init);
+void resetqsmodel( qsmodel *m, const int *init);
 
 
 /* deletion of qsmodel m                               */
@@ -38,102 +38,24 @@
   oriented arithmetic coding, but then I had no knowledge of Martin's
   paper from 1997.
 
-  The input and output is done by the inbyte and outbyte macros
-  defined in the .c file; change them as needed; the first parameter
-  passed to them is a pointer to the rangecoder structure; extend that
-  structure as needed (and don't forget to initialize the values in
-  start_encoding resp. start_decoding). This distribution writes to
-  stdout and reads from stdin.
+  The input and output is done by the rc_inbyte and rc_outbyte macros
+  defined in rangecod.h, with the functions called for each symbol.
 
   There are no global or static var's, so if the IO is thread save the
-  whole rangecoder is - unless GLOBALRANGECODER in rangecod.h is defined.
+  whole rangecoder is.
 
   For error recovery the last 3 bytes written contain the total number
   of bytes written since starting the encoder. This can be used to
   locate the beginning of a block if you have only the end. The header
   size you pass to initrangecoder is included in that count.
 
-  There is a supplementary file called renorm95.c available at the
-  website (www.compressconsult.com/rangecoder/) that changes the range
-  coder to an arithmetic coder for speed comparisons.
-
-  define RENORM95 if you want the arithmetic coder type renormalisation.
-  Requires renorm95.c
-  Note that the old version does not write out the bytes since init.
-  you should not define GLOBALRANGECODER then. This Flag is provided
-  only for spped comparisons between both renormalizations, see my
-  data compression conference article 1998 for details.
-*/
-/* #define RENORM95 */
-
-/*
-  define NOWARN if you do not expect more than 2^32 outstanding bytes 
-  since I recommend restarting the coder in intervals of less than    
-  2^23 symbols for error tolerance this is not expected
 */
-#define NOWARN
-
-/*
-  define EXTRAFAST for increased speed; you loose compression and
-  compatibility in exchange.
-*/
-/* #define EXTRAFAST */
 
 #include <stdio.h>		/* fprintf(), getchar(), putchar(), NULL */
 #include "port.h"
 #include "rangecod.h"
 
-/* SIZE OF RANGE ENCODING CODE VALUES. */
-
-#define CODE_BITS 32
-#define Top_value ((code_value)1 << (CODE_BITS-1))
-
-
-/* all IO is done by these macros - change them if you want to */
-/* no checking is done - do it here if you want it             */
-/* cod is a pointer to the used rangecoder                     */
-//#define outbyte(cod,x) putchar(x)
-#define outbyte(cod,x) *(cod->p_data + (*cod->p_dataOffset)++) = x
-#define inbyte(cod)    *(cod->p_data + (*cod->p_dataOffset)++)
-
-#ifdef RENORM95
-#include "renorm95.c"
-
-#else
-#define SHIFT_BITS (CODE_BITS - 9)
-#define EXTRA_BITS ((CODE_BITS-2) % 8 + 1)
-#define Bottom_value (Top_value >> 8)
-
-#ifdef NOWARN
-#ifdef GLOBALRANGECODER
-char coderversion[]="rangecoder 1.3 NOWARN GLOBAL (c) 1997-2000 Michael Schindler";
-#else
 char coderversion[]="rangecoder 1.3 NOWARN (c) 1997-2000 Michael Schindler";
-#endif
-#else    /*NOWARN*/
-#ifdef GLOBALRANGECODER
-char coderversion[]="rangecoder 1.3 GLOBAL (c) 1997-2000 Michael Schindler";
-#else
-char coderversion[]="rangecoder 1.3 (c) 1997-2000 Michael Schindler";
-#endif
-#endif   /*NOWARN*/
-#endif   /*RENORM95*/
-
-
-#ifdef GLOBALRANGECODER
-/* if this is defined we'll make a global variable rngc and    */
-/* make RNGC use that var; we'll also omit unneeded parameters */
-static rangecoder rngc;
-#define RNGC (rngc)
-#define M_outbyte(a) outbyte(&rngc,a)
-#define M_inbyte inbyte(&rngc)
-#define enc_normalize(rc) M_enc_normalize()
-#define dec_normalize(rc) M_dec_normalize()
-#else
-#define RNGC (*rc)
-#define M_outbyte(a) outbyte(rc,a)
-#define M_inbyte inbyte(rc)
-#endif
 
 
 /* rc is the range coder to be used                            */
@@ -141,44 +63,12 @@ static rangecoder rngc;
 /* one could do without c, but then you have an additional if  */
 /* per outputbyte.                                             */
 void start_encoding( rangecoder *rc, char c, int initlength )
-{   RNGC.low = 0;                /* Full code range */
-    RNGC.range = Top_value;
-    RNGC.buffer = c;
-    RNGC.help = 0;               /* No bytes to follow */
-    RNGC.bytecount = initlength;
-}
-
-
-#ifndef RENORM95
-/* I do the normalization before I need a defined state instead of */
-/* after messing it up. This simplifies starting and ending.       */
-static Inline void enc_normalize( rangecoder *rc )
-{   while(RNGC.range <= Bottom_value)     /* do we need renormalisation?  */
-    {   if (RNGC.low < (code_value)0xff<<SHIFT_BITS)  /* no carry possible --> output */
-        {   M_outbyte(RNGC.buffer);
-            for(; RNGC.help; RNGC.help--)
-                M_outbyte(0xff);
-            RNGC.buffer = (unsigned char)(RNGC.low >> SHIFT_BITS);
-        } else if (RNGC.low & Top_value) /* carry now, no future carry */
-        {   M_outbyte(RNGC.buffer+1);
-            for(; RNGC.help; RNGC.help--)
-                M_outbyte(0);
-            RNGC.buffer = (unsigned char)(RNGC.low >> SHIFT_BITS);
-        } else                           /* passes on a potential carry */
-#ifdef NOWARN
-            RNGC.help++;
-#else
-            if (RNGC.bytestofollow++ == 0xffffffffL)
-            {   fprintf(stderr,"Too many bytes outstanding - File too large\n");
-                exit(1);
-            }
-#endif
-        RNGC.range <<= 8;
-        RNGC.low = (RNGC.low<<8) & (Top_value-1);
-        RNGC.bytecount++;
-    }
+{   rc->low = 0;                /* Full code range */
+    rc->range = Top_value;
+    rc->buffer = c;
+    rc->help = 0;               /* No bytes to follow */
+    rc->bytecount = initlength;
 }
-#endif
 
 
 /* Encode a symbol using frequencies                         */
@@ -186,41 +76,29 @@ static Inline void enc_normalize( rangecoder *rc )
 /* sy_f is the interval length (frequency of the symbol)     */
 /* lt_f is the lower end (frequency sum of < symbols)        */
 /* tot_f is the total interval length (total frequency sum)  */
-/* or (faster): tot_f = (code_value)1<<shift                             */
+/* encode_shift() in rangecod.h is faster for tot_f = 1<<shift */
 void encode_freq( rangecoder *rc, freq sy_f, freq lt_f, freq tot_f )
 {	code_value r, tmp;
 	enc_normalize( rc );
-	r = RNGC.range / tot_f;
+	r = rc->range / tot_f;
 	tmp = r * lt_f;
-	RNGC.low += tmp;
-#ifdef EXTRAFAST
-    RNGC.range = r * sy_f;
-#else
+	rc->low += tmp;
     if (lt_f+sy_f < tot_f)
-		RNGC.range = r * sy_f;
+		rc->range = r * sy_f;
     else
-		RNGC.range -= tmp;
-#endif
+		rc->range -= tmp;
 }
 
-void encode_shift( rangecoder *rc, freq sy_f, freq lt_f, freq shift )
-{	code_value r, tmp;
-	enc_normalize( rc );
-	r = RNGC.range >> shift;
-	tmp = r * lt_f;
-	RNGC.low += tmp;
-#ifdef EXTRAFAST
-	RNGC.range = r * sy_f;
-#else
-	if ((lt_f+sy_f) >> shift)
-		RNGC.range -= tmp;
-	else  
-		RNGC.range = r * sy_f;
-#endif
+
+void encode_varint( rangecoder *rc, uint4 v )
+{   while (v >= 0x80)
+    {   encode_byte(rc, (v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    encode_byte(rc, v);
 }
 
 
-#ifndef RENORM95
 /* Finish encoding                                           */
 /* rc is the range coder to be used                          */
 /* actually not that many bytes need to be output, but who   */
@@ -229,25 +107,25 @@ void encode_shift( rangecoder *rc, freq sy_f, freq lt_f, freq shift )
 uint4 done_encoding( rangecoder *rc )
 {   uint tmp;
     enc_normalize(rc);     /* now we have a normalized state */
-    RNGC.bytecount += 5;
-    if ((RNGC.low & (Bottom_value-1)) < ((RNGC.bytecount&0xffffffL)>>1))
-       tmp = RNGC.low >> SHIFT_BITS;
+    rc->bytecount += 5;
+    if ((rc->low & (Bottom_value-1)) < ((rc->bytecount&0xffffffL)>>1))
+       tmp = rc->low >> SHIFT_BITS;
     else
-       tmp = (RNGC.low >> SHIFT_BITS) + 1;
+       tmp = (rc->low >> SHIFT_BITS) + 1;
     if (tmp > 0xff) /* we have a carry */
-    {   M_outbyte(RNGC.buffer+1);
-        for(; RNGC.help; RNGC.help--)
-            M_outbyte(0);
+    {   rc_outbyte(rc, rc->buffer+1);
+        for(; rc->help; rc->help--)
+            rc_outbyte(rc, 0);
     } else  /* no carry */
-    {   M_outbyte(RNGC.buffer);
-        for(; RNGC.help; RNGC.help--)
-            M_outbyte(0xff);
+    {   rc_outbyte(rc, rc->buffer);
+        for(; rc->help; rc->help--)
+            rc_outbyte(rc, 0xff);
     }
-    M_outbyte(tmp & 0xff);
-    M_outbyte((RNGC.bytecount>>16) & 0xff);
-    M_outbyte((RNGC.bytecount>>8) & 0xff);
-    M_outbyte(RNGC.bytecount & 0xff);
-    return RNGC.bytecount;
+    rc_outbyte(rc, tmp & 0xff);
+    rc_outbyte(rc, (rc->bytecount>>16) & 0xff);
+    rc_outbyte(rc, (rc->bytecount>>8) & 0xff);
+    rc_outbyte(rc, rc->bytecount & 0xff);
+    return rc->bytecount;
 }
 
 
@@ -255,74 +133,26 @@ uint4 done_encoding( rangecoder *rc )
 /* rc is the range coder to be used                          */
 /* returns the char from start_encoding or EOF               */
 int start_decoding( rangecoder *rc )
-{   int c = M_inbyte;
+{   int c = rc_inbyte(rc);
     if (c==EOF)
         return EOF;
-    RNGC.buffer = M_inbyte;
-    RNGC.low = RNGC.buffer >> (8-EXTRA_BITS);
-    RNGC.range = (code_value)1 << EXTRA_BITS;
+    rc->buffer = rc_inbyte(rc);
+    rc->low = rc->buffer >> (8-EXTRA_BITS);
+    rc->range = (code_value)1 << EXTRA_BITS;
     return c;
 }
 
 
-static Inline void dec_normalize( rangecoder *rc )
-{   while (RNGC.range <= Bottom_value)
-    {   RNGC.low = (RNGC.low<<8) | ((RNGC.buffer<<EXTRA_BITS)&0xff);
-        RNGC.buffer = M_inbyte;
-        RNGC.low |= RNGC.buffer >> (8-EXTRA_BITS);
-        RNGC.range <<= 8;
-    }
-}
-#endif
-
-
 /* Calculate culmulative frequency for next symbol. Does NO update!*/
 /* rc is the range coder to be used                          */
 /* tot_f is the total frequency                              */
-/* or: totf is (code_value)1<<shift                                      */
 /* returns the culmulative frequency                         */
 freq decode_culfreq( rangecoder *rc, freq tot_f )
 {   freq tmp;
     dec_normalize(rc);
-    RNGC.help = RNGC.range/tot_f;
-    tmp = RNGC.low/RNGC.help;
-#ifdef EXTRAFAST
-    return tmp;
-#else
+    rc->help = rc->range/tot_f;
+    tmp = rc->low/rc->help;
     return (tmp>=tot_f ? tot_f-1 : tmp);
-#endif
-}
-
-freq decode_culshift( rangecoder *rc, freq shift )
-{   freq tmp;
-    dec_normalize(rc);
-    RNGC.help = RNGC.range>>shift;
-    tmp = RNGC.low/RNGC.help;
-#ifdef EXTRAFAST
-    return tmp;
-#else
-    return (tmp>>shift ? ((code_value)1<<shift)-1 : tmp);
-#endif
-}
-
-
-/* Update decoding state                                     */
-/* rc is the range coder to be used                          */
-/* sy_f is the interval length (frequency of the symbol)     */
-/* lt_f is the lower end (frequency sum of < symbols)        */
-/* tot_f is the total interval length (total frequency sum)  */
-void decode_update( rangecoder *rc, freq sy_f, freq lt_f, freq tot_f)
-{   code_value tmp;
-    tmp = RNGC.help * lt_f;
-    RNGC.low -= tmp;
-#ifdef EXTRAFAST
-    RNGC.range = RNGC.help * sy_f;
-#else
-    if (lt_f + sy_f < tot_f)
-        RNGC.range = RNGC.help * sy_f;
-    else
-        RNGC.range -= tmp;
-#endif
 }
 
 
@@ -341,6 +171,23 @@ unsigned short decode_short(rangecoder *rc)
 }
 
 
+int decode_varint(rangecoder *rc, uint4 *v)
+{   int shift = 0;
+    unsigned char tmp;
+    *v = 0;
+    do
+    {   if (shift > 28)
+            return 1;
+        tmp = decode_byte(rc);
+        if (shift == 28 && tmp > 0x0f)
+            return 1;
+        *v |= (uint4)(tmp & 0x7f) << shift;
+        shift += 7;
+    } while (tmp & 0x80);
+    return 0;
+}
+
+
 /* Finish decoding                                           */
 /* rc is the range coder to be used                          */
 void done_decoding( rangecoder *rc )
@@ -45,29 +45,25 @@ extern "C" {
   oriented arithmetic coding, but then I had no knowledge of Martin's
   paper from 1979.
 
-  The input and output is done by the INBYTE and OUTBYTE macros
-  defined in the .c file; change them as needed; the first parameter
-  passed to them is a pointer to the rangecoder structure; extend that
-  structure as needed (and don't forget to initialize the values in
-  start_encoding resp. start_decoding). This distribution writes to
-  stdout and reads from stdin.
+  The input and output is done by the rc_outbyte and rc_inbyte macros
+  below, on the databuffer of the rangecoder structure.
 
   There are no global or static var's, so if the IO is thread save the
-  whole rangecoder is - unless GLOBALRANGECODER in rangecod.h is defined.
+  whole rangecoder is.
 
   For error recovery the last 3 bytes written contain the total number
   of bytes written since starting the encoder. This can be used to
   locate the beginning of a block if you have only the end.
 
-  For some application using a global coder variable may provide a better
-  performance. This will allow you to use only one coder at a time and
-  will destroy thread savety. To enabble this feature uncomment the
-  #define GLOBALRANGECODER line below.
+  The functions called for each symbol are inline, so that the coding
+  loops of the callers need no call and the constant shifts, like the
+  ones of the binary models and of the raw bits, are folded by the
+  compiler. The others are in rangecod.c.
 */
-/* #define GLOBALRANGECODER */
 
 
 #include "port.h"
+#include "databuffer.h"
 #if 0    /* done in port.h */
 #include <limits.h>
 #if INT_MAX > 0xffff
@@ -99,26 +95,23 @@ typedef struct {
 /* the following is used only when encoding */
     uint4 bytecount;     /* counter for outputed bytes  */
 /* insert fields you need for input/output below this line! */
-    char *p_data;
-    size_t *p_dataOffset;
+    databuffer *p_buffer;
 } rangecoder;
 
 
-/* supply the following as methods of the arithcoder object  */
-/* omit the first parameter then (C++)                       */
-#ifdef GLOBALRANGECODER
-#define start_encoding(rc,a,b) M_start_encoding(a,b)
-#define encode_freq(rc,a,b,c) M_encode_freq(a,b,c)
-#define encode_shift(rc,a,b,c) M_encode_shift(a,b,c)
-#define done_encoding(rc) M_done_encoding()
-#define start_decoding(rc) M_start_decoding()
-#define decode_culfreq(rc,a) M_decode_culfreq(a)
-#define decode_culshift(rc,a) M_decode_culshift(a)
-#define decode_update(rc,a,b,c) M_decode_update(a,b,c)
-#define decode_byte(rc) M_decode_byte()
-#define decode_short(rc) M_decode_short()
-#define done_decoding(rc) M_done_decoding()
-#endif
+/* SIZE OF RANGE ENCODING CODE VALUES. */
+
+#define CODE_BITS 32
+#define Top_value ((code_value)1 << (CODE_BITS-1))
+#define SHIFT_BITS (CODE_BITS - 9)
+#define EXTRA_BITS ((CODE_BITS-2) % 8 + 1)
+#define Bottom_value (Top_value >> 8)
+
+/* all IO is done by these macros - change them if you want to */
+/* bounds are checked by the databuffer functions               */
+/* cod is a pointer to the used rangecoder                     */
+#define rc_outbyte(cod,x) dbputbyte((cod)->p_buffer,x)
+#define rc_inbyte(cod)    dbgetbyte((cod)->p_buffer)
 
 
 /* Start the encoder                                         */
@@ -134,7 +127,7 @@ void start_encoding( rangecoder *rc, char c, int initlength);
 /* tot_f is the total interval length (total frequency sum)  */
 /* or (a lot faster): tot_f = 1<<shift                       */
 void encode_freq( rangecoder *rc, freq sy_f, freq lt_f, freq tot_f );
-void encode_shift( rangecoder *rc, freq sy_f, freq lt_f, freq shift );
+static Inline void encode_shift( rangecoder *rc, freq sy_f, freq lt_f, freq shift );
 
 /* Encode a byte/short without modelling                     */
 /* rc is the range coder to be used                          */
@@ -142,6 +135,10 @@ void encode_shift( rangecoder *rc, freq sy_f, freq lt_f, freq shift );
 #define encode_byte(ac,b)  encode_shift(ac,(freq)1,(freq)(b),(freq)8)
 #define encode_short(ac,s) encode_shift(ac,(freq)1,(freq)(s),(freq)16)
 
+/* Encode an unsigned integer on a variable number of bytes  */
+/* 7 bits per byte, the high bit tells if more bytes follow  */
+void encode_varint(rangecoder *rc, uint4 v);
+
 
 /* Finish encoding                                           */
 /* rc is the range coder to be shut down                     */
@@ -161,26 +158,115 @@ int start_decoding( rangecoder *rc );
 /* or: totf is 1<<shift                                      */
 /* returns the <= culmulative frequency                      */
 freq decode_culfreq( rangecoder *rc, freq tot_f );
-freq decode_culshift( rangecoder *ac, freq shift );
+static Inline freq decode_culshift( rangecoder *rc, freq shift );
 
 /* Update decoding state                                     */
 /* rc is the range coder to be used                          */
 /* sy_f is the interval length (frequency of the symbol)     */
 /* lt_f is the lower end (frequency sum of < symbols)        */
 /* tot_f is the total interval length (total frequency sum)  */
-void decode_update( rangecoder *rc, freq sy_f, freq lt_f, freq tot_f);
+static Inline void decode_update( rangecoder *rc, freq sy_f, freq lt_f, freq tot_f);
 #define decode_update_shift(rc,f1,f2,f3) decode_update((rc),(f1),(f2),(freq)1<<(f3));
 
+/* Decode a binary symbol and update the decoding state      */
+/* without division                                          */
+/* rc is the range coder to be used                          */
+/* f0 is the frequency of the 0, the total being 1<<shift    */
+/* returns the decoded bit                                   */
+static Inline int decode_bit_shift( rangecoder *rc, freq f0, freq shift );
+
 /* Decode a byte/short without modelling                     */
 /* rc is the range coder to be used                          */
 unsigned char decode_byte(rangecoder *rc);
 unsigned short decode_short(rangecoder *rc);
 
+/* Decode an unsigned integer written by encode_varint       */
+/* at most 5 bytes are read, the last one with 4 bits        */
+/* returns 0 on success, 1 if the integer is corrupted       */
+int decode_varint(rangecoder *rc, uint4 *v);
+
 
 /* Finish decoding                                           */
 /* rc is the range coder to be used                          */
 void done_decoding( rangecoder *rc );
 
+
+/* I do the normalization before I need a defined state instead of */
+/* after messing it up. This simplifies starting and ending.       */
+static Inline void enc_normalize( rangecoder *rc )
+{   while(rc->range <= Bottom_value)      /* do we need renormalisation?  */
+    {   if (rc->low < (code_value)0xff<<SHIFT_BITS)  /* no carry possible --> output */
+        {   rc_outbyte(rc, rc->buffer);
+            for(; rc->help; rc->help--)
+                rc_outbyte(rc, 0xff);
+            rc->buffer = (unsigned char)(rc->low >> SHIFT_BITS);
+        } else if (rc->low & Top_value)  /* carry now, no future carry */
+        {   rc_outbyte(rc, rc->buffer+1);
+            for(; rc->help; rc->help--)
+                rc_outbyte(rc, 0);
+            rc->buffer = (unsigned char)(rc->low >> SHIFT_BITS);
+        } else                           /* passes on a potential carry */
+            rc->help++;
+        rc->range <<= 8;
+        rc->low = (rc->low<<8) & (Top_value-1);
+        rc->bytecount++;
+    }
+}
+
+static Inline void encode_shift( rangecoder *rc, freq sy_f, freq lt_f, freq shift )
+{   code_value r, tmp;
+    enc_normalize( rc );
+    r = rc->range >> shift;
+    tmp = r * lt_f;
+    rc->low += tmp;
+    if ((lt_f+sy_f) >> shift)
+        rc->range -= tmp;
+    else
+        rc->range = r * sy_f;
+}
+
+
+static Inline void dec_normalize( rangecoder *rc )
+{   while (rc->range <= Bottom_value)
+    {   rc->low = (rc->low<<8) | ((rc->buffer<<EXTRA_BITS)&0xff);
+        rc->buffer = rc_inbyte(rc);
+        rc->low |= rc->buffer >> (8-EXTRA_BITS);
+        rc->range <<= 8;
+    }
+}
+
+static Inline freq decode_culshift( rangecoder *rc, freq shift )
+{   freq tmp;
+    dec_normalize(rc);
+    rc->help = rc->range>>shift;
+    tmp = rc->low/rc->help;
+    return (tmp>>shift ? ((code_value)1<<shift)-1 : tmp);
+}
+
+static Inline void decode_update( rangecoder *rc, freq sy_f, freq lt_f, freq tot_f)
+{   code_value tmp;
+    tmp = rc->help * lt_f;
+    rc->low -= tmp;
+    if (lt_f + sy_f < tot_f)
+        rc->range = rc->help * sy_f;
+    else
+        rc->range -= tmp;
+}
+
+static Inline int decode_bit_shift( rangecoder *rc, freq f0, freq shift )
+{   code_value bound;
+    dec_normalize(rc);
+    rc->help = rc->range>>shift;
+    bound = rc->help * f0;
+    if (rc->low < bound)        /* same as decode_culshift() < f0 */
+    {   rc->range = bound;
+        return 0;
+    }
+    rc->low -= bound;
+    rc->range -= bound;
+    return 1;
+}
+
 #ifdef __cplusplus
 }
 #endif
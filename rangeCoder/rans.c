@@ -0,0 +1,185 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "rans.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* lower bound of the normalized states, which are in [RANS_L, RANS_L << 8) */
+#define RANS_L ((uint4)1 << 23)
+
+void initranscoder(ranscoder *rc, databuffer *p_buffer) {
+    memset(rc, 0, sizeof(ranscoder));
+    rc->p_buffer = p_buffer;
+}
+
+void deleteranscoder(ranscoder *rc) {
+    free(rc->p_symbols);
+    free(rc->p_bytes);
+    initranscoder(rc, rc->p_buffer);
+}
+
+void rans_start_encoding(ranscoder *rc) {
+    rc->i_nbSymbols = 0;
+}
+
+void rans_encode_shift(ranscoder *rc, uint4 sy_f, uint4 lt_f, uint4 shift) {
+    ranssymbol *p_sym;
+
+    assert(sy_f > 0 && shift <= 23);
+
+    if (rc->i_nbSymbols == rc->i_symbolCapacity) {
+        rc->i_symbolCapacity = rc->i_symbolCapacity ? 2 * rc->i_symbolCapacity : 4096;
+        rc->p_symbols = (ranssymbol *)realloc(rc->p_symbols, rc->i_symbolCapacity * sizeof(ranssymbol));
+        if (rc->p_symbols == NULL)
+            abort();
+    }
+
+    p_sym = rc->p_symbols + rc->i_nbSymbols++;
+    p_sym->sy_f = sy_f;
+    p_sym->lt_f = lt_f;
+    p_sym->shift = (unsigned char)shift;
+}
+
+void rans_encode_varint(ranscoder *rc, uint4 v) {
+    while (v >= 0x80) {
+        rans_encode_shift(rc, 1, (v & 0x7f) | 0x80, 8);
+        v >>= 7;
+    }
+    rans_encode_shift(rc, 1, v, 8);
+}
+
+uint4 rans_done_encoding(ranscoder *rc) {
+    uint4 x[RANS_NB_STATES];
+    unsigned i_nbStates = rc->i_nbSymbols < RANS_MIN_INTERLEAVED_SYMBOLS ? 1 : RANS_NB_STATES;
+    unsigned char *p_out;
+    size_t i, i_size;
+    databuffer *b = rc->p_buffer;
+
+    /* a symbol writes at most 3 bytes and each state 4 bytes */
+    i_size = 3 * rc->i_nbSymbols + 4 * RANS_NB_STATES;
+    if (i_size > rc->i_byteCapacity) {
+        free(rc->p_bytes);
+        rc->i_byteCapacity = i_size;
+        rc->p_bytes = (unsigned char *)malloc(i_size);
+        if (rc->p_bytes == NULL)
+            abort();
+    }
+    p_out = rc->p_bytes + i_size;
+
+    for (i = 0; i < RANS_NB_STATES; ++i)
+        x[i] = RANS_L;
+
+    /* code the symbols backwards, each one with the state that will decode it */
+    for (i = rc->i_nbSymbols; i-- > 0;) {
+        const ranssymbol *p_sym = rc->p_symbols + i;
+        uint4 *p_x = x + i % i_nbStates;
+        uint4 x_max = ((RANS_L >> p_sym->shift) << 8) * p_sym->sy_f;
+
+        while (*p_x >= x_max) {
+            *--p_out = (unsigned char)*p_x;
+            *p_x >>= 8;
+        }
+        *p_x = ((*p_x / p_sym->sy_f) << p_sym->shift) + *p_x % p_sym->sy_f + p_sym->lt_f;
+    }
+
+    /* the states, the first one at the beginning, most significant byte first */
+    if (i_nbStates == 1)
+        x[0] |= (uint4)1 << 31;
+    for (i = i_nbStates; i-- > 0;) {
+        *--p_out = (unsigned char)x[i];
+        *--p_out = (unsigned char)(x[i] >> 8);
+        *--p_out = (unsigned char)(x[i] >> 16);
+        *--p_out = (unsigned char)(x[i] >> 24);
+    }
+
+    i_size = rc->p_bytes + i_size - p_out;
+    if (b->offset + i_size > b->capacity)
+        reservedatabuffer(b, b->offset + i_size);
+    memcpy(b->p_data + b->offset, p_out, i_size);
+    b->offset += i_size;
+    if (b->offset > b->size)
+        b->size = b->offset;
+
+    rc->i_nbSymbols = 0;
+    return (uint4)i_size;
+}
+
+void rans_start_decoding(ranscoder *rc, size_t i_endOffset) {
+    unsigned i, j;
+    rc->i_endOffset = i_endOffset;
+    rc->b_corrupted = 0;
+    rc->i_nbStates = RANS_NB_STATES;
+    for (i = 0; i < rc->i_nbStates; ++i) {
+        rc->x[i] = 0;
+        for (j = 0; j < 4; ++j)
+            rc->x[i] = rc->x[i] << 8 | dbgetbyte(rc->p_buffer);
+
+        /* a single state block */
+        if (rc->x[0] >> 31) {
+            rc->x[0] &= ~((uint4)1 << 31);
+            rc->i_nbStates = 1;
+        }
+    }
+    rc->i_curState = 0;
+}
+
+void rans_decode_update(ranscoder *rc, uint4 sy_f, uint4 lt_f, uint4 shift) {
+    uint4 x = rc->x[rc->i_curState];
+
+    x = sy_f * (x >> shift) + (x & (((uint4)1 << shift) - 1)) - lt_f;
+    while (x < RANS_L) {
+        /* a null state would never grow back, and the valid states never
+           need bytes past the end of the data: the data is corrupted */
+        if (x == 0 || rc->p_buffer->offset >= rc->i_endOffset) {
+            rc->b_corrupted = 1;
+            x = RANS_L;
+            break;
+        }
+        x = x << 8 | dbgetbyte(rc->p_buffer);
+    }
+
+    rc->x[rc->i_curState] = x;
+    if (++rc->i_curState == rc->i_nbStates)
+        rc->i_curState = 0;
+}
+
+int rans_decode_varint(ranscoder *rc, uint4 *v) {
+    uint4 tmp;
+    int shift = 0;
+    *v = 0;
+    do {
+        if (shift > 28)
+            return 1;
+        tmp = rans_decode_culshift(rc, 8);
+        rans_decode_update(rc, 1, tmp, 8);
+        if (shift == 28 && tmp > 0x0f)
+            return 1;
+        *v |= (tmp & 0x7f) << shift;
+        shift += 7;
+    } while (tmp & 0x80);
+    return 0;
+}
+
+int rans_done_decoding(ranscoder *rc) {
+    /* all the bytes of the block are read when the decoding ends */
+    return rc->b_corrupted;
+}
@@ -0,0 +1,132 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef RANS_H
+#define RANS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  rans.h     interleaved rANS entropy coder
+
+  An alternative to the range coder with the same symbol interface:
+  the symbols are given with their frequency, their cumulative frequency
+  and the base 2 log of the total frequency, as with encode_shift().
+
+  Several rANS states are interleaved: symbol i is coded with the state
+  i % RANS_NB_STATES, so the decoding of consecutive symbols does not
+  depend on the same state. Decoding needs no division. Each state costs
+  4 bytes at the beginning of a block, so the blocks of less than
+  RANS_MIN_INTERLEAVED_SYMBOLS symbols use a single state. This is told
+  by the high bit of the first byte, which is free as the states are
+  lower than 1 << 31.
+
+  rANS decodes the symbols in the reverse order of their encoding. As
+  the models are adaptive, the encoder only records the symbols and codes
+  them backwards in rans_done_encoding(). The decoder reads the bytes
+  forward, in the same order as the range coder.
+*/
+
+#include <stddef.h>
+
+#include "port.h"
+#include "databuffer.h"
+
+/* number of interleaved states */
+#define RANS_NB_STATES 2
+
+/* minimal number of symbols of an interleaved block */
+#define RANS_MIN_INTERLEAVED_SYMBOLS 4096
+
+/* a recorded symbol, waiting for rans_done_encoding() */
+typedef struct {
+    uint4 sy_f;           /* frequency of the symbol */
+    uint4 lt_f;           /* frequency of all smaller symbols together */
+    unsigned char shift;  /* base 2 log of the total frequency */
+} ranssymbol;
+
+typedef struct {
+    uint4 x[RANS_NB_STATES];  /* the states */
+    unsigned i_nbStates;      /* number of states of the decoded block */
+    unsigned i_curState;      /* state of the next decoded symbol */
+    size_t i_endOffset;       /* end of the decoded data in the buffer */
+    int b_corrupted;          /* set when the decoded data is found corrupted */
+/* the following is used only when encoding */
+    ranssymbol *p_symbols;    /* the recorded symbols */
+    size_t i_nbSymbols, i_symbolCapacity;
+    unsigned char *p_bytes;   /* the output, written backwards */
+    size_t i_byteCapacity;
+    databuffer *p_buffer;
+} ranscoder;
+
+/* initialisation of the coder structure; does not allocate */
+void initranscoder(ranscoder *rc, databuffer *p_buffer);
+
+/* deletion of the encoder memory */
+void deleteranscoder(ranscoder *rc);
+
+/* Start the encoder                                         */
+void rans_start_encoding(ranscoder *rc);
+
+/* Encode a symbol: sy_f and lt_f as in encode_shift(),     */
+/* the total frequency is 1<<shift with shift <= 23          */
+void rans_encode_shift(ranscoder *rc, uint4 sy_f, uint4 lt_f, uint4 shift);
+
+/* Encode an unsigned integer on a variable number of bytes  */
+void rans_encode_varint(ranscoder *rc, uint4 v);
+
+/* Finish encoding: code the recorded symbols and write     */
+/* them at the current offset of the buffer                  */
+/* returns number of bytes written                           */
+uint4 rans_done_encoding(ranscoder *rc);
+
+/* Start the decoder at the current offset of the buffer    */
+/* the data to decode ends before i_endOffset                */
+void rans_start_decoding(ranscoder *rc, size_t i_endOffset);
+
+/* Cumulative frequency of the next symbol. Does NO update! */
+static Inline uint4 rans_decode_culshift(ranscoder *rc, uint4 shift) {
+    return rc->x[rc->i_curState] & (((uint4)1 << shift) - 1);
+}
+
+/* Update the decoding state with the decoded symbol        */
+void rans_decode_update(ranscoder *rc, uint4 sy_f, uint4 lt_f, uint4 shift);
+
+/* Decode a binary symbol of 0 frequency f0 and update     */
+static Inline int rans_decode_bit_shift(ranscoder *rc, uint4 f0, uint4 shift) {
+    int bit = rans_decode_culshift(rc, shift) >= f0;
+    rans_decode_update(rc, bit ? ((uint4)1 << shift) - f0 : f0, bit ? f0 : 0, shift);
+    return bit;
+}
+
+/* Decode an unsigned integer written by rans_encode_varint */
+/* returns 0 on success, 1 if the integer is corrupted       */
+int rans_decode_varint(ranscoder *rc, uint4 *v);
+
+/* Finish decoding                                           */
+/* returns 0 on success, 1 if the data is corrupted          */
+int rans_done_decoding(ranscoder *rc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
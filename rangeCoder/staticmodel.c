@@ -0,0 +1,106 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "staticmodel.h"
+
+#include <stdlib.h>
+
+int normalizefreqs( const uint4 *counts, int n, int lg_totf, uint4 *freqs ) {
+    unsigned long long i_total = 0;
+    uint4 i_totf = (uint4)1 << lg_totf, i_sum = 0;
+    int i, i_nbUsed = 0, i_max = 0;
+
+    for (i = 0; i < n; ++i) {
+        i_total += counts[i];
+        i_nbUsed += counts[i] != 0;
+        if (counts[i] > counts[i_max])
+            i_max = i;
+    }
+    if (i_total == 0 || i_nbUsed > (int)i_totf)
+        return 0;
+
+    /* rounded scaling, the occurring symbols keeping a frequency */
+    for (i = 0; i < n; ++i) {
+        freqs[i] = (uint4)((counts[i] * (unsigned long long)i_totf + i_total / 2) / i_total);
+        if (freqs[i] == 0 && counts[i] != 0)
+            freqs[i] = 1;
+        i_sum += freqs[i];
+    }
+
+    /* the most frequent symbol absorbs the rounding errors */
+    if (i_sum <= i_totf || freqs[i_max] > i_sum - i_totf)
+        freqs[i_max] += i_totf - i_sum;
+    else {
+        /* too many rare symbols: take from the largest frequencies */
+        while (i_sum > i_totf) {
+            uint4 d;
+            i_max = 0;
+            for (i = 1; i < n; ++i)
+                if (freqs[i] > freqs[i_max])
+                    i_max = i;
+            d = freqs[i_max] / 2;
+            if (d > i_sum - i_totf)
+                d = i_sum - i_totf;
+            freqs[i_max] -= d;
+            i_sum -= d;
+        }
+    }
+    return 1;
+}
+
+void initstaticmodel( staticmodel *m, int n, int lg_totf, int compress ) {
+    m->n = n;
+    m->lg_totf = lg_totf;
+    m->cf = (uint4 *)malloc((n + 1) * sizeof(uint4));
+    m->lookup = NULL;
+    if (m->cf == NULL)
+        abort();
+    if (!compress) {
+        m->lookup = (uint2 *)malloc(((size_t)1 << lg_totf) * sizeof(uint2));
+        if (m->lookup == NULL)
+            abort();
+    }
+}
+
+void resetstaticmodel( staticmodel *m, const uint4 *freqs ) {
+    uint4 i_totf = (uint4)1 << m->lg_totf, cf = 0;
+    int i;
+
+    for (i = 0; i < m->n; ++i) {
+        m->cf[i] = cf;
+        cf += freqs[i];
+        if (cf > i_totf)
+            cf = i_totf;
+    }
+    m->cf[m->n] = i_totf;
+
+    if (m->lookup != NULL) {
+        uint4 j = 0;
+        for (i = 0; i < m->n; ++i)
+            for (; j < m->cf[i + 1]; ++j)
+                m->lookup[j] = (uint2)i;
+    }
+}
+
+void deletestaticmodel( staticmodel *m ) {
+    free(m->cf);
+    free(m->lookup);
+    m->cf = NULL;
+    m->lookup = NULL;
+}
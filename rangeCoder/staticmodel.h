@@ -0,0 +1,85 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef STATICMODEL_H
+#define STATICMODEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  staticmodel.h     static probability model with table-lookup decoding
+
+  The frequencies of a static model are fixed: they are computed by the
+  encoder from the symbol counts and transmitted before the symbols. The
+  total frequency is 1<<lg_totf, so the decoder finds a symbol from its
+  cumulative frequency with a lookup in an array of 1<<lg_totf entries
+  instead of a search, and there is no model update.
+*/
+
+#include "port.h"
+
+typedef struct {
+    int n,         /* number of symbols */
+        lg_totf;   /* base2 log of total frequency count */
+    uint4 *cf;     /* array of cumulative frequencies */
+    uint2 *lookup; /* symbol of each cumulative frequency, on decompression */
+} staticmodel;
+
+/* normalisation of symbol counts to frequencies              */
+/* counts  number of occurrences of the n symbols            */
+/* freqs   the frequencies, summing to 1<<lg_totf; a symbol   */
+/*         that occurs has a frequency of at least 1          */
+/* returns 0 if more than 1<<lg_totf symbols occur            */
+int normalizefreqs( const uint4 *counts, int n, int lg_totf, uint4 *freqs );
+
+/* initialisation of staticmodel, without frequencies  */
+/* m   staticmodel to be initialized                   */
+/* n   number of symbols in that model, at most 1<<16  */
+/* lg_totf  base2 log of total frequency count         */
+/* compress  set to 1 on compression, 0 on decompression */
+void initstaticmodel( staticmodel *m, int n, int lg_totf, int compress );
+
+/* setting of the frequencies of staticmodel, in place */
+/* m   staticmodel to be set                           */
+/* freqs  frequencies of the symbols; the slots after  */
+/*        a sum lower than 1<<lg_totf decode to the    */
+/*        last symbol, the ones after 1<<lg_totf are   */
+/*        ignored                                      */
+void resetstaticmodel( staticmodel *m, const uint4 *freqs );
+
+/* deletion of staticmodel m                           */
+void deletestaticmodel( staticmodel *m );
+
+/* retrieval of the frequencies of a symbol, as qsgetfreq() */
+static Inline void staticgetfreq( const staticmodel *m, int sym, int *sy_f, int *lt_f ) {
+    *sy_f = m->cf[sym + 1] - (*lt_f = m->cf[sym]);
+}
+
+/* symbol for a given cumulative frequency             */
+static Inline int staticgetsym( const staticmodel *m, int lt_f ) {
+    return m->lookup[lt_f];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
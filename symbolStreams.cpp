@@ -0,0 +1,78 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "symbolStreams.h"
+
+#include <stdio.h>
+
+/**
+ * Read the symbol streams written by writeSymbolStreams().
+ * \return false if the file can not be read or is corrupted.
+ */
+bool readSymbolStreams(const char* psz_filePath, std::vector<SymbolStream>& streams) {
+    FILE* p_file = fopen(psz_filePath, "r");
+    if (p_file == NULL)
+        return false;
+
+    bool b_ok = true;
+    char name[256];
+    unsigned i_nbSymbols, i_lgTotFreq, i_rescale, i_nbContexts;
+    unsigned long i_length;
+    while (b_ok && fscanf(p_file, " stream %255s %u %u %u %u %lu", name, &i_nbSymbols, &i_lgTotFreq, &i_rescale,
+                          &i_nbContexts, &i_length) == 6) {
+        SymbolStream stream;
+        stream.name = name;
+        stream.i_nbSymbols = i_nbSymbols;
+        stream.i_lgTotFreq = i_lgTotFreq;
+        stream.i_rescale = i_rescale;
+        stream.i_nbContexts = i_nbContexts;
+        stream.symbols.resize(i_length);
+        stream.contexts.resize(i_length);
+
+        for (unsigned long i = 0; i < i_length && b_ok; ++i) {
+            b_ok = fscanf(p_file, "%u:%u", &stream.symbols[i], &stream.contexts[i]) == 2 &&
+                   stream.symbols[i] < i_nbSymbols && stream.contexts[i] < i_nbContexts;
+        }
+        streams.push_back(stream);
+    }
+
+    b_ok = b_ok && feof(p_file);
+    fclose(p_file);
+    return b_ok;
+}
+
+/**
+ * Write the symbol streams, each one as a header line followed by its symbol:context pairs.
+ * \return false if the file can not be written.
+ */
+bool writeSymbolStreams(const char* psz_filePath, const std::vector<SymbolStream>& streams) {
+    FILE* p_file = fopen(psz_filePath, "w");
+    if (p_file == NULL)
+        return false;
+
+    for (const SymbolStream& stream : streams) {
+        fprintf(p_file, "stream %s %u %u %u %u %lu\n", stream.name.c_str(), stream.i_nbSymbols, stream.i_lgTotFreq,
+                stream.i_rescale, stream.i_nbContexts, (unsigned long)stream.symbols.size());
+        for (size_t i = 0; i < stream.symbols.size(); ++i)
+            fprintf(p_file, "%u:%u%c", stream.symbols[i], stream.contexts[i], i % 16 == 15 ? '\n' : ' ');
+        fprintf(p_file, "\n");
+    }
+
+    return fclose(p_file) == 0;
+}
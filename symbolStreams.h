@@ -0,0 +1,51 @@
+/*****************************************************************************
+ * Copyright (C) 2011 Adrien Maglo and Clément Courbet
+ *
+ * This file is part of PPMC.
+ *
+ * PPMC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PPMC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PPMC.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef SYMBOLSTREAMS_H
+#define SYMBOLSTREAMS_H
+
+/*
+  Symbol streams of the entropy coding models.
+
+  The compressor records the symbols given to its models with the
+  --record-symbols option. The coder benchmark replays them, to measure
+  the entropy coders and the models on real data without compressing a
+  mesh each time.
+*/
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// The symbols of a kind of model, in their coding order.
+struct SymbolStream {
+    std::string name;
+    unsigned i_nbSymbols;   // Size of the alphabet. The streams of 2 symbols are coded with binary models.
+    unsigned i_lgTotFreq;   // Base 2 log of the total frequency of the models.
+    unsigned i_rescale;     // Rescaling interval of the adaptive models.
+    unsigned i_nbContexts;  // Number of models, each symbol being coded with the one of its context.
+    std::vector<uint32_t> symbols;
+    std::vector<uint32_t> contexts;
+};
+
+bool readSymbolStreams(const char* psz_filePath, std::vector<SymbolStream>& streams);
+bool writeSymbolStreams(const char* psz_filePath, const std::vector<SymbolStream>& streams);
+
+#endif  // SYMBOLSTREAMS_H